@@ -0,0 +1,268 @@
+/// Copyright (c) 2017-2020 Ashley Brighthope
+/// SPDX-License-Identifier: BSL-1.0
+
+#include "BenchGStreamer.hpp"
+#include <Pothos/Exception.hpp>
+#include <Pothos/Init.hpp>
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <ctime>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <new>
+#include <stdexcept>
+#include <vector>
+
+namespace
+{
+    std::atomic< uint64_t > allocations{ 0 };
+    thread_local uint64_t threadAllocations = 0;
+}  // namespace
+
+// Replaced for the whole process, so allocations in the Pothos and GStreamer modules are counted too
+void* operator new(std::size_t size)
+{
+    allocations.fetch_add( 1, std::memory_order_relaxed );
+    ++threadAllocations;
+    auto *ptr = std::malloc( ( size == 0 ) ? 1 : size );
+    if ( ptr == nullptr )
+    {
+        throw std::bad_alloc();
+    }
+    return ptr;
+}
+
+void* operator new[](std::size_t size)
+{
+    return operator new( size );
+}
+
+void operator delete(void *ptr) noexcept
+{
+    std::free( ptr );
+}
+
+void operator delete[](void *ptr) noexcept
+{
+    std::free( ptr );
+}
+
+void operator delete(void *ptr, std::size_t /* size */) noexcept
+{
+    std::free( ptr );
+}
+
+void operator delete[](void *ptr, std::size_t /* size */) noexcept
+{
+    std::free( ptr );
+}
+
+namespace GstBench
+{
+    uint64_t allocationCount()
+    {
+        return allocations.load( std::memory_order_relaxed );
+    }
+
+    uint64_t threadAllocationCount()
+    {
+        return threadAllocations;
+    }
+
+    double cpuSeconds()
+    {
+        return static_cast< double >( std::clock() ) / CLOCKS_PER_SEC;
+    }
+
+    Sample Sample::now()
+    {
+        return Sample{ std::chrono::steady_clock::now(), cpuSeconds(), allocationCount() };
+    }
+
+    json measure(const Sample &start, const Sample &end, uint64_t operations)
+    {
+        json result;
+        result[ "seconds"     ] = std::chrono::duration< double >( end.time - start.time ).count();
+        result[ "cpuSeconds"  ] = end.cpuSeconds - start.cpuSeconds;
+        result[ "allocations" ] = end.allocations - start.allocations;
+        if ( operations != 0 )
+        {
+            result[ "cpuPerOpNs"       ] = ( end.cpuSeconds - start.cpuSeconds ) * 1e9 / static_cast< double >( operations );
+            result[ "allocationsPerOp" ] = static_cast< double >( end.allocations - start.allocations ) / static_cast< double >( operations );
+        }
+        return result;
+    }
+
+    struct RegisteredSuite
+    {
+        Suite suite;
+        bool loadsModules;
+    };
+
+    static std::map< std::string, RegisteredSuite >& suites()
+    {
+        static std::map< std::string, RegisteredSuite > _suites;
+        return _suites;
+    }
+
+    RegisterSuite::RegisterSuite(const std::string &name, Suite suite, bool loadsModules)
+    {
+        suites()[ name ] = RegisteredSuite{ std::move( suite ), loadsModules };
+    }
+
+}  // namespace GstBench
+
+using GstBench::json;
+
+namespace
+{
+    void usage(const char *program)
+    {
+        std::cout << "Usage: " << program << " [--output file.json] [--baseline file.json] [suite...]\n";
+        std::cout << "Runs the given benchmark suites, or all of them, and prints the results as JSON.\n";
+        std::cout << "With a baseline, the output of an earlier run, each result also gets the change against it.\n";
+        std::cout << "Exits with failure if any result is marked \"failed\", for running suites as tests.\n";
+        std::cout << "Allocations are those made through operator new, GLib allocations are not counted.\n";
+        std::cout << "Suites:";
+        for (const auto &suite : GstBench::suites())
+        {
+            std::cout << " " << suite.first;
+        }
+        std::cout << std::endl;
+    }
+
+    /**
+     * Add the ratio against the same result in the baseline, for each per op figure, > 1.0 being more than before
+     */
+    void compareToBaseline(json &results, const json &baseline)
+    {
+        std::map< std::string, json > baselineResults;
+        for (const auto &result : baseline.at( "benchmarks" ))
+        {
+            baselineResults[ result.at( "suite" ).get< std::string >() + "/" + result.at( "name" ).get< std::string >() ] = result;
+        }
+
+        for (auto &result : results)
+        {
+            const auto baseline_it = baselineResults.find( result.at( "suite" ).get< std::string >() + "/" + result.at( "name" ).get< std::string >() );
+            if ( baseline_it == baselineResults.end() )
+            {
+                continue;
+            }
+            for (const auto *key : { "nsPerOp", "cpuPerOpNs", "allocationsPerOp" })
+            {
+                if ( result.count( key ) != 0 && baseline_it->second.count( key ) != 0 && baseline_it->second[ key ].get< double >() > 0.0 )
+                {
+                    result[ std::string( key ) + "Change" ] = result[ key ].get< double >() / baseline_it->second[ key ].get< double >();
+                }
+            }
+        }
+    }
+}  // namespace
+
+int main(int argc, char *argv[])
+{
+    std::vector< std::string > selected;
+    std::string outputFile;
+    std::string baselineFile;
+    for (int index = 1; index < argc; ++index)
+    {
+        const std::string arg( argv[ index ] );
+        if ( arg == "--output" && index + 1 < argc )
+        {
+            outputFile = argv[ ++index ];
+        }
+        else if ( arg == "--baseline" && index + 1 < argc )
+        {
+            baselineFile = argv[ ++index ];
+        }
+        else if ( arg == "--help" || arg == "-h" )
+        {
+            usage( argv[ 0 ] );
+            return EXIT_SUCCESS;
+        }
+        else if ( GstBench::suites().count( arg ) == 0 )
+        {
+            std::cerr << "Unknown suite: " << arg << std::endl;
+            usage( argv[ 0 ] );
+            return EXIT_FAILURE;
+        }
+        else
+        {
+            selected.push_back( arg );
+        }
+    }
+
+    const auto isSelected = [ &selected ](const std::string &suite)
+    {
+        return selected.empty() || std::find( selected.begin(), selected.end(), suite ) != selected.end();
+    };
+
+    try
+    {
+        // Only loaded for suites that run blocks, see RegisterSuite
+        std::unique_ptr< Pothos::ScopedInit > init;
+        for (const auto &suite : GstBench::suites())
+        {
+            if ( isSelected( suite.first ) && suite.second.loadsModules && !init )
+            {
+                init.reset( new Pothos::ScopedInit() );
+            }
+        }
+
+        json results = json::array();
+        for (const auto &suite : GstBench::suites())
+        {
+            if ( !isSelected( suite.first ) )
+            {
+                continue;
+            }
+            for (auto result : suite.second.suite())
+            {
+                result[ "suite" ] = suite.first;
+                results.push_back( std::move( result ) );
+            }
+        }
+
+        if ( !baselineFile.empty() )
+        {
+            std::ifstream baseline( baselineFile );
+            if ( !baseline )
+            {
+                std::cerr << "Could not read baseline: " << baselineFile << std::endl;
+                return EXIT_FAILURE;
+            }
+            compareToBaseline( results, json::parse( baseline ) );
+        }
+
+        const auto failed = std::any_of( results.begin(), results.end(),
+            [ ](const json &result) { return result.value( "failed", false ); }
+        );
+
+        json report;
+        report[ "benchmarks" ] = std::move( results );
+        std::cout << report.dump( 2 ) << std::endl;
+        if ( !outputFile.empty() )
+        {
+            std::ofstream( outputFile ) << report.dump( 2 ) << std::endl;
+        }
+        if ( failed )
+        {
+            return EXIT_FAILURE;
+        }
+    }
+    catch (const Pothos::Exception &e)
+    {
+        std::cerr << e.displayText() << std::endl;
+        return EXIT_FAILURE;
+    }
+    catch (const std::exception &e)
+    {
+        std::cerr << e.what() << std::endl;
+        return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+}
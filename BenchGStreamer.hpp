@@ -0,0 +1,92 @@
+/// Copyright (c) 2017-2020 Ashley Brighthope
+/// SPDX-License-Identifier: BSL-1.0
+
+#pragma once
+
+#include <json.hpp>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <string>
+
+/**
+ * Harness of the BenchGStreamer and BenchGStreamerTypes programs, each suite of benchmarks registers itself with a static RegisterSuite.
+ * Results are written as JSON, so runs can be compared over time to catch regressions.
+ */
+namespace GstBench
+{
+    using json = nlohmann::json;
+
+    //! @return Heap allocations made through operator new since the program started, in any thread, not those of GLib
+    uint64_t allocationCount();
+
+    //! @return Heap allocations made through operator new by the calling thread since it started
+    uint64_t threadAllocationCount();
+
+    //! @return CPU time used by the process, all threads, in seconds
+    double cpuSeconds();
+
+    //! Point in time to measure from
+    struct Sample
+    {
+        std::chrono::steady_clock::time_point time;
+        double cpuSeconds;
+        uint64_t allocations;
+
+        static Sample now();
+    };
+
+    /**
+     * @return {"seconds", "cpuSeconds", "allocations"} from start to end,
+     *         and "cpuPerOpNs", "allocationsPerOp" for the given number of operations.
+     *         Allocations are those through operator new, GLib allocations such as of a GstBuffer are not counted.
+     */
+    json measure(const Sample &start, const Sample &end, uint64_t operations);
+
+    /**
+     * Run an operation over and over, doubling the iterations until it takes at least minSeconds.
+     * @return {"name", "iterations", "nsPerOp"} and measure() of the last round
+     */
+    template< typename Fn >
+    json microbenchmark(const std::string &name, Fn &&op, double minSeconds = 0.5)
+    {
+        // Warm up caches and lazily created state
+        op();
+
+        uint64_t iterations = 1;
+        while ( true )
+        {
+            const auto start = Sample::now();
+            for (uint64_t iteration = 0; iteration < iterations; ++iteration)
+            {
+                op();
+            }
+            const auto end = Sample::now();
+
+            const auto seconds = std::chrono::duration< double >( end.time - start.time ).count();
+            if ( seconds >= minSeconds )
+            {
+                auto result = measure( start, end, iterations );
+                result[ "name"       ] = name;
+                result[ "iterations" ] = iterations;
+                result[ "nsPerOp"    ] = seconds * 1e9 / static_cast< double >( iterations );
+                return result;
+            }
+            iterations *= 2;
+        }
+    }
+
+    //! A suite returns an array of results, each an object with a "name"
+    using Suite = std::function< json() >;
+
+    struct RegisterSuite
+    {
+        /**
+         * @param loadsModules The suite runs blocks, so the Pothos modules are loaded before it.
+         *        Those suites go in BenchGStreamer, the others in programs linking module sources such as GStreamerTypes.cpp,
+         *        which would otherwise have a second copy of the module's code and static state next to the loaded one.
+         */
+        RegisterSuite(const std::string &name, Suite suite, bool loadsModules = false);
+    };
+
+}  // namespace GstBench
@@ -0,0 +1,316 @@
+/// Copyright (c) 2017-2020 Ashley Brighthope
+/// SPDX-License-Identifier: BSL-1.0
+
+#include "BenchGStreamer.hpp"
+#include <Pothos/Framework.hpp>
+#include <Pothos/Plugin.hpp>
+#include <Pothos/Proxy.hpp>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <memory>
+#include <string>
+#include <thread>
+
+using GstBench::json;
+
+namespace
+{
+    /**
+     * Posts packets of one size, as fast as possible or at a given rate
+     */
+    class BenchSource final : public Pothos::Block
+    {
+    private:
+        const Pothos::BufferChunk m_payload;
+        const uint64_t m_buffers;
+        const double m_rate;
+        uint64_t m_sent;
+        std::chrono::steady_clock::time_point m_start;
+
+    public:
+        BenchSource(size_t size, uint64_t buffers, double rate) :
+            m_payload( size ),
+            m_buffers( buffers ),
+            m_rate( rate ),
+            m_sent( 0 ),
+            m_start( )
+        {
+            this->setupOutput( 0 );
+        }
+
+        void activate() override
+        {
+            m_sent = 0;
+            m_start = std::chrono::steady_clock::now();
+        }
+
+        void work() override
+        {
+            if ( m_sent >= m_buffers )
+            {
+                return;
+            }
+            if ( m_rate > 0.0 )
+            {
+                // Sleep until the next one is due rather than spinning, the CPU time is measured for the whole process
+                const auto next = m_start + std::chrono::duration_cast< std::chrono::steady_clock::duration >( std::chrono::duration< double >( m_sent / m_rate ) );
+                const auto wait = next - std::chrono::steady_clock::now();
+                if ( wait > std::chrono::steady_clock::duration::zero() )
+                {
+                    std::this_thread::sleep_for( std::min< std::chrono::steady_clock::duration >( wait, std::chrono::nanoseconds( this->workInfo().maxTimeoutNs ) ) );
+                    this->yield();
+                    return;
+                }
+            }
+
+            // Shares the one payload, so the source itself does not allocate per buffer
+            Pothos::Packet packet;
+            packet.payload = m_payload;
+            this->output( 0 )->postMessage( std::move( packet ) );
+            ++m_sent;
+        }
+    };  // class BenchSource
+
+    /**
+     * Counts the packets and bytes it gets, and samples the time, CPU and allocations at the first and last one.
+     * Calls warmedUp once it has half of them, while the rest are still coming.
+     */
+    class BenchSink final : public Pothos::Block
+    {
+    private:
+        const uint64_t m_expected;
+        const std::function< void() > m_warmedUp;
+        uint64_t m_buffers;
+        uint64_t m_bytes;
+        GstBench::Sample m_first;
+        GstBench::Sample m_last;
+        std::atomic_bool m_done;
+
+    public:
+        BenchSink(uint64_t expected, std::function< void() > warmedUp) :
+            m_expected( expected ),
+            m_warmedUp( std::move( warmedUp ) ),
+            m_buffers( 0 ),
+            m_bytes( 0 ),
+            m_first( ),
+            m_last( ),
+            m_done( false )
+        {
+            this->setupInput( 0 );
+        }
+
+        void work() override
+        {
+            auto inputPort = this->input( 0 );
+            while ( inputPort->hasMessage() )
+            {
+                const auto message = inputPort->popMessage();
+                if ( message.type() != typeid( Pothos::Packet ) )
+                {
+                    continue;
+                }
+                const auto length = message.extract< Pothos::Packet >().payload.length;
+                // An EOS comes without a buffer
+                if ( length == 0 || m_done )
+                {
+                    continue;
+                }
+                if ( m_buffers == 0 )
+                {
+                    m_first = GstBench::Sample::now();
+                }
+                ++m_buffers;
+                m_bytes += length;
+                if ( m_warmedUp && m_buffers == m_expected / 2 )
+                {
+                    m_warmedUp();
+                }
+                if ( m_buffers == m_expected )
+                {
+                    m_last = GstBench::Sample::now();
+                    m_done = true;
+                }
+            }
+        }
+
+        bool done() const
+        {
+            return m_done;
+        }
+
+        //! Call once done, or after giving up on it
+        json result() const
+        {
+            json result;
+            result[ "buffers" ] = m_buffers;
+            if ( !m_done )
+            {
+                result[ "error" ] = "timeout";
+                return result;
+            }
+            // Rates between the first and last buffer, leaving out the pipeline start up
+            auto measured = GstBench::measure( m_first, m_last, m_buffers - 1 );
+            const auto seconds = measured[ "seconds" ].get< double >();
+            if ( seconds > 0.0 )
+            {
+                measured[ "buffersPerSecond" ] = static_cast< double >( m_buffers - 1 ) / seconds;
+                measured[ "bytesPerSecond"   ] = static_cast< double >( m_bytes - m_bytes / m_buffers ) / seconds;
+            }
+            result.update( measured );
+            return result;
+        }
+    };  // class BenchSink
+
+    const size_t PACKET_SIZES[]{ 64, 1500, 65536 };
+    //! Buffers per second, 0 for as fast as possible
+    const double RATES[]{ 0.0, 10000.0 };
+    const uint64_t BUFFERS = 10000;
+
+    /**
+     * Run one case through a block with "in" and "out" ports, with the bench source connected to "in" when the block has it.
+     * warmedUp is called from the sink once half the buffers are through.
+     */
+    json runThrough(const Pothos::Proxy &block, bool withSource, size_t size, double rate, const std::function< void() > &warmedUp = nullptr)
+    {
+        auto source = std::make_shared< BenchSource >( size, BUFFERS, rate );
+        auto sink = std::make_shared< BenchSink >( BUFFERS, warmedUp );
+
+        {
+            Pothos::Topology topology;
+            if ( withSource )
+            {
+                topology.connect( source, 0, block, "in" );
+            }
+            topology.connect( block, "out", sink, 0 );
+            topology.commit();
+
+            const auto expectedSeconds = ( rate > 0.0 ) ? static_cast< double >( BUFFERS ) / rate : 0.0;
+            const auto deadline = std::chrono::steady_clock::now() + std::chrono::duration_cast< std::chrono::steady_clock::duration >( std::chrono::duration< double >( 30.0 + expectedSeconds ) );
+            while ( !sink->done() && std::chrono::steady_clock::now() < deadline )
+            {
+                std::this_thread::sleep_for( std::chrono::milliseconds( 10 ) );
+            }
+        }
+
+        return sink->result();
+    }
+
+    json runPassthrough(const std::string &name, const std::string &pipeline, bool withSource, size_t size, double rate)
+    {
+        json result = runThrough( Pothos::BlockRegistry::make( "/media/gstreamer", pipeline ), withSource, size, rate );
+        result[ "name"     ] = name + "/size=" + std::to_string( size ) + "/rate=" + std::to_string( static_cast< uint64_t >( rate ) );
+        result[ "pipeline" ] = pipeline;
+        result[ "size"     ] = size;
+        result[ "rate"     ] = rate;
+        return result;
+    }
+
+    json benchPassthrough()
+    {
+        json results = json::array();
+        for (const auto size : PACKET_SIZES)
+        {
+            for (const auto rate : RATES)
+            {
+                results.push_back( runPassthrough( "appsrc", "appsrc name=in ! appsink name=out sync=false", true, size, rate ) );
+
+                // fakesrc is paced by the clock from its data rate
+                std::string fakesrc( "fakesrc num-buffers=" + std::to_string( BUFFERS ) + " sizetype=fixed sizemax=" + std::to_string( size ) );
+                if ( rate > 0.0 )
+                {
+                    fakesrc += " datarate=" + std::to_string( static_cast< uint64_t >( rate * size ) ) + " ! appsink name=out sync=true";
+                }
+                else
+                {
+                    fakesrc += " ! appsink name=out sync=false";
+                }
+                results.push_back( runPassthrough( "fakesrc", fakesrc, false, size, rate ) );
+            }
+        }
+        return results;
+    }
+
+    const GstBench::RegisterSuite registerPassthrough( "passthrough", &benchPassthrough, true );
+
+    //! Heap allocations the GStreamer block may make on the buffer path once warmed up in the minimal metadata mode
+    const uint64_t MINIMAL_ALLOCATIONS_LIMIT = 0;
+
+    //! Where the GStreamer block finds the allocation counter, GStreamerPortStats::ALLOCATION_COUNTER_PATH
+    const char ALLOCATION_COUNTER_PATH[]{ "/media/gstreamer/allocation_counter" };
+    //! As GStreamerPortStats::AllocationCounter, the type the block expects at the path
+    using AllocationCounter = uint64_t (*)();
+
+    //! @return false if a port has no "allocations", the block did not count them
+    bool sumPortAllocations(const Pothos::ObjectKwargs &portStats, uint64_t &allocations)
+    {
+        allocations = 0;
+        for (const auto &port : portStats)
+        {
+            const auto &stats = port.second.extract< Pothos::ObjectKwargs >();
+            const auto allocations_it = stats.find( "allocations" );
+            if ( allocations_it == stats.end() )
+            {
+                return false;
+            }
+            allocations += allocations_it->second.extract< uint64_t >();
+        }
+        return !portStats.empty();
+    }
+
+    /**
+     * Heap allocations on the buffer path of appsrc ! appsink, in sendToGStreamer() and the appsink work(), from when half the buffers are through.
+     * The block counts them itself on the thread running those, with the counter of this program's operator new registered for it.
+     * Fails in the minimal metadata mode unless there are none at all, the full mode is reported only.
+     * Not counted: the GstBuffer and GstMemory wrapping each payload and the GstSample pulled from the appsink, which GLib allocates
+     * with malloc where operator new does not see them and GStreamer gives no way to pool for wrapped memory,
+     * and the message container the framework allocates for each packet posted to the output port.
+     */
+    json benchAllocations()
+    {
+        const size_t size = 1500;
+        const std::string pipeline( "appsrc name=in ! appsink name=out sync=false" );
+
+        // Looked up by the block when it is made
+        const AllocationCounter counter = &GstBench::threadAllocationCount;
+        Pothos::PluginRegistry::add( ALLOCATION_COUNTER_PATH, Pothos::Object( counter ) );
+
+        json results = json::array();
+        for (const auto *mode : { "MINIMAL", "FULL" })
+        {
+            auto gstreamer = Pothos::BlockRegistry::make( "/media/gstreamer", pipeline );
+            gstreamer.call( "setMetadataMode", std::string( mode ) );
+
+            Pothos::ObjectKwargs warmStats;
+            json result = runThrough( gstreamer, true, size, 0.0, [ & ]() { warmStats = gstreamer.call< Pothos::ObjectKwargs >( "getPortStats" ); } );
+            const auto endStats = gstreamer.call< Pothos::ObjectKwargs >( "getPortStats" );
+            result[ "name"     ] = std::string( "appsrc/metadata=" ) + mode;
+            result[ "pipeline" ] = pipeline;
+            result[ "size"     ] = size;
+
+            uint64_t warmAllocations = 0;
+            uint64_t endAllocations = 0;
+            if ( result.count( "error" ) != 0 || !sumPortAllocations( warmStats, warmAllocations ) || !sumPortAllocations( endStats, endAllocations ) )
+            {
+                result[ "failed" ] = true;
+                results.push_back( std::move( result ) );
+                continue;
+            }
+
+            const auto allocations = endAllocations - warmAllocations;
+            result[ "blockAllocations" ] = allocations;
+            if ( std::string( mode ) == "MINIMAL" )
+            {
+                result[ "limit"  ] = MINIMAL_ALLOCATIONS_LIMIT;
+                result[ "failed" ] = ( allocations > MINIMAL_ALLOCATIONS_LIMIT );
+            }
+            results.push_back( std::move( result ) );
+        }
+
+        Pothos::PluginRegistry::remove( ALLOCATION_COUNTER_PATH );
+        return results;
+    }
+
+    const GstBench::RegisterSuite registerAllocations( "allocations", &benchAllocations, true );
+}  // namespace
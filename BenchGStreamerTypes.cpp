@@ -0,0 +1,105 @@
+/// Copyright (c) 2017-2020 Ashley Brighthope
+/// SPDX-License-Identifier: BSL-1.0
+
+#include "BenchGStreamer.hpp"
+#include "GStreamerTypes.hpp"
+#include <gst/gst.h>
+#include <memory>
+#include <string>
+
+using GstBench::json;
+
+namespace
+{
+    using GstCapsPtr = std::unique_ptr< GstCaps, GstTypes::detail::Deleter< GstCaps, gst_caps_unref > >;
+    using GstTagListPtr = std::unique_ptr< GstTagList, GstTypes::detail::Deleter< GstTagList, gst_tag_list_unref > >;
+
+    const char AUDIO_CAPS[]{ "audio/x-raw, format=(string)S16LE, layout=(string)interleaved, rate=(int)44100, channels=(int)2, channel-mask=(bitmask)0x3" };
+
+    //! Tag list as from a well tagged file, with many comments and extended comments
+    GstTagListPtr makeLargeTagList()
+    {
+        GstTagListPtr tags( gst_tag_list_new_empty() );
+        gst_tag_list_add( tags.get(), GST_TAG_MERGE_APPEND,
+            GST_TAG_TITLE, "Benchmark title",
+            GST_TAG_ARTIST, "Benchmark artist",
+            GST_TAG_ALBUM, "Benchmark album",
+            GST_TAG_GENRE, "Benchmark genre",
+            GST_TAG_TRACK_NUMBER, 7U,
+            GST_TAG_TRACK_COUNT, 12U,
+            GST_TAG_BITRATE, 320000U,
+            GST_TAG_DURATION, static_cast< guint64 >( 180 * GST_SECOND ),
+            GST_TAG_AUDIO_CODEC, "MPEG-1 Layer 3 (MP3)",
+            nullptr
+        );
+        for (int index = 0; index < 32; ++index)
+        {
+            const auto comment = "Comment number " + std::to_string( index );
+            gst_tag_list_add( tags.get(), GST_TAG_MERGE_APPEND, GST_TAG_COMMENT, comment.c_str(), nullptr );
+            const auto extended = "key" + std::to_string( index ) + "=" + comment;
+            gst_tag_list_add( tags.get(), GST_TAG_MERGE_APPEND, GST_TAG_EXTENDED_COMMENT, extended.c_str(), nullptr );
+        }
+        return tags;
+    }
+
+    //! Buffer with every time stamp, offset and flag set
+    GstTypes::GstBufferPtr makeFlaggedBuffer(size_t size)
+    {
+        GstTypes::GstBufferPtr buffer( gst_buffer_new_allocate( nullptr, size, nullptr ) );
+        GST_BUFFER_PTS       ( buffer.get() ) = 10 * GST_SECOND;
+        GST_BUFFER_DTS       ( buffer.get() ) = 9 * GST_SECOND;
+        GST_BUFFER_DURATION  ( buffer.get() ) = 20 * GST_MSECOND;
+        GST_BUFFER_OFFSET    ( buffer.get() ) = 1000;
+        GST_BUFFER_OFFSET_END( buffer.get() ) = 1000 + size;
+        for (const auto &flag : GstTypes::GST_BUFFER_FLAG_LIST)
+        {
+            GST_BUFFER_FLAG_SET( buffer.get(), flag.second );
+        }
+        return buffer;
+    }
+
+    json benchTypes()
+    {
+        gst_init( nullptr, nullptr );
+
+        json results = json::array();
+
+        {
+            GstTypes::GVal intValue( G_TYPE_INT );
+            g_value_set_int( &intValue.value, 44100 );
+            results.push_back( GstBench::microbenchmark( "gvalueToObject/int", [ &intValue ]() { GstTypes::gvalueToObject( &intValue.value ); } ) );
+
+            GstTypes::GVal stringValue( G_TYPE_STRING );
+            g_value_set_string( &stringValue.value, "interleaved" );
+            results.push_back( GstBench::microbenchmark( "gvalueToObject/string", [ &stringValue ]() { GstTypes::gvalueToObject( &stringValue.value ); } ) );
+
+            GstTypes::GVal fractionValue( GST_TYPE_FRACTION );
+            gst_value_set_fraction( &fractionValue.value, 30000, 1001 );
+            results.push_back( GstBench::microbenchmark( "gvalueToObject/fraction", [ &fractionValue ]() { GstTypes::gvalueToObject( &fractionValue.value ); } ) );
+        }
+
+        {
+            const GstCapsPtr caps( gst_caps_from_string( AUDIO_CAPS ) );
+            const auto *structure = gst_caps_get_structure( caps.get(), 0 );
+            results.push_back( GstBench::microbenchmark( "gstStructureToObjectKwargs/audioCaps", [ structure ]() { GstTypes::gstStructureToObjectKwargs( structure ); } ) );
+        }
+
+        {
+            const auto tags = makeLargeTagList();
+            results.push_back( GstBench::microbenchmark( "gstTagListToObjectKwargs/large", [ &tags ]() { GstTypes::gstTagListToObjectKwargs( tags.get() ); } ) );
+        }
+
+        for (const size_t size : { 64, 65536 })
+        {
+            const auto buffer = makeFlaggedBuffer( size );
+            results.push_back( GstBench::microbenchmark( "makePacketFromGstBuffer/allFlags/size=" + std::to_string( size ), [ &buffer ]() { GstTypes::makePacketFromGstBuffer( buffer.get() ); } ) );
+
+            const auto packet = GstTypes::makePacketFromGstBuffer( buffer.get() );
+            results.push_back( GstBench::microbenchmark( "makeGstBufferFromPacket/allFlags/size=" + std::to_string( size ), [ &packet ]() { GstTypes::makeGstBufferFromPacket( packet ); } ) );
+        }
+
+        return results;
+    }
+
+    const GstBench::RegisterSuite registerTypes( "types", &benchTypes );
+}  // namespace
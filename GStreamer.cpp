@@ -11,7 +11,7 @@
  * <ul>
  *   <li><b>getPipelineString()</b><p style="margin-left:2.0em">Returns the current pipeline string.</p></li>
  *   <li><b>setState(state)</b><p style="margin-left:2.0em">Changes the state of the pipeline. Can be "PLAY" or "PAUSE".</p></li>
- *   <li><b>getPipeline()</b><p style="margin-left:2.0em">Returns a pointer to the current running GstPipeline.</p></li>
+ *   <li><b>getPipeline()</b><p style="margin-left:2.0em">Returns a pointer to the current running GstPipeline, or null if the block is not active.</p></li>
  *   <li><b>getPipelineLatency()</b><p style="margin-left:2.0em">Returns the current pipeline latency in ns.</p></li>
  *   <li><b>getPipelinePosition(format)</b><p style="margin-left:2.0em">Returns the position in the stream in a given format.<br>
  *     If unknown it throws Pothos::PropertyNotSupportedException.<br>
@@ -21,6 +21,79 @@
  *     If unknown it throws Pothos::PropertyNotSupportedException.<br>
  *     <b>format</b> Can be "DEFAULT", "BYTES", "TIME", "BUFFERS" or "PERCENT"</p>
  *   </li>
+ *   <li><b>getProcessingSpeed()</b><p style="margin-left:2.0em">Returns the stream time processed against the time since the pipeline started playing, 1.0 is real time.<br>
+ *     In loop mode the stream time of the earlier loops is counted too.<br>
+ *     If the position is unknown, or the pipeline has not been playing, it throws Pothos::PropertyNotSupportedException.</p></li>
+ *   <li><b>getLoopCount()</b><p style="margin-left:2.0em">Returns how many times the stream was restarted from the start in loop mode, since activation.</p></li>
+ *   <li><b>getStreamingThreadCount()</b><p style="margin-left:2.0em">Returns how many streaming threads got the streamingCpus and streamingNice settings applied, since activation.</p></li>
+ *   <li><b>getPortStats()</b><p style="margin-left:2.0em">Returns the stats of every port since activation, by port name, to find bottlenecks:<br>
+ *     <b>buffers</b> and <b>bytes</b> through the port, <b>drops</b> of messages that could not be used, <b>flowErrors</b> returned by GStreamer,<br>
+ *     <b>occupancyHistogram</b> of how full the appsrc or appsink queue was for each buffer, 0% to 100% in 10% steps,<br>
+ *     <b>interArrivalHistogram</b> of the time between buffers, bin n counting gaps of 2^(n-1) to 2^n microseconds,<br>
+ *     <b>latency</b> of appsink ports when measureLatency is enabled, see getLatencyStats(),<br>
+ *     <b>allocations</b> made on the buffer path of the port, only when the program registers an allocation counter, as BenchGStreamer does.</p>
+ *   </li>
+ *   <li><b>getLatencyStats()</b><p style="margin-left:2.0em">Returns the latency from appsrc push to appsink, by appsink port name, when measureLatency is enabled:<br>
+ *     <b>samples</b> measured since activation, <b>p50</b> and <b>p99</b> over the last 1024 buffers, and the <b>max</b>, in ns.</p>
+ *   </li>
+ *   <li><b>getTracerStats()</b><p style="margin-left:2.0em">Returns what the enabled tracers recorded about the pipeline since activation, to find hot elements:<br>
+ *     <b>elements</b> by path from the pipeline, e.g. "replica1/filter", with the <b>latency</b> through the element (count, meanNs, maxNs) from the latency tracer,
+ *     and the <b>buffers</b> and <b>bytes</b> it pushed from the stats tracer.
+ *     The stats tracer only names the parents of elements it first sees in their pipeline, so elements of pipelines made after it was enabled get no buffers or bytes,<br>
+ *     <b>pipelineLatency</b> from the appsrc or source to a sink, from the latency tracer,<br>
+ *     <b>averageCpuLoad</b> and <b>currentCpuLoad</b> of the whole process in percent, from the rusage tracer.<br>
+ *     Also sent on the "tracerStats" signal every statsInterval.</p>
+ *   </li>
+ *   <li><b>enableElementTiming(names)</b><p style="margin-left:2.0em">Times the elements with the given names or paths, e.g. "replica1/filter", or all elements but bins when empty, with buffer pad probes.
+ *     The n-th buffer leaving a src pad of the element is timed from the n-th buffer reaching a sink pad,
+ *     for elements with a streaming thread of their own, such as queue, this includes the time waiting in it.
+ *     Only elements that push one buffer for each they get are timed right, not e.g. encoders or tee.
+ *     Pads added later, such as request pads, are timed too.
+ *     Applied to the running pipeline straight away, and again on each activation, restarting the times from zero.</p></li>
+ *   <li><b>disableElementTiming()</b><p style="margin-left:2.0em">Removes the pad probes of enableElementTiming(), leaving no overhead behind. The times are kept for getElementTiming().</p></li>
+ *   <li><b>getElementTiming()</b><p style="margin-left:2.0em">Returns the times of the elements enabled with enableElementTiming(), by element path from the pipeline:<br>
+ *     <b>count</b>, <b>meanNs</b>, <b>maxNs</b> and a <b>histogram</b> of the times, bin n counting 2^(n-1) to 2^n ns.</p>
+ *   </li>
+ *   <li><b>getTeardownDuration()</b><p style="margin-left:2.0em">Returns how long the last pipeline teardown took in ns.</p></li>
+ *   <li><b>replaceBin(name, description)</b><p style="margin-left:2.0em">Replaces an element or bin of the running pipeline, without stopping it.<br>
+ *     Data is held back in front of the element while it is drained, then flows into the replacement, so the ports stay live.
+ *     The swap is done once data reaches the element, when done a "bin-swapped" (or "bin-swap-failed") application message is sent on the bus signal.<br>
+ *     <b>name</b> Name of the element to replace, it must have a single sink and source pad and can not contain an appsrc or appsink port.
+ *     An element can only be replaced once its previous swap is done.<br>
+ *     <b>description</b> Pipeline description of the replacement, e.g. <code>"x264enc bitrate=2000"</code>. It gets the name of the element it replaces.
+ *     </p>
+ *   </li>
+ *   <li><b>setElementProperty(name, property, value)</b><p style="margin-left:2.0em">Sets a property of an element in the running pipeline.
+ *     Like every method, also available as a slot, so it can be driven from a signal.<br>
+ *     <b>name</b> Name of the element, or a path of bin names to it when the name is used in more than one bin, e.g. <code>"replica1/encoder"</code>.<br>
+ *     <b>property</b> Name of the property.<br>
+ *     <b>value</b> New value. Numbers and bools are converted to the property type, strings are parsed like in a pipeline description, e.g. enum nicks or caps.
+ *     </p>
+ *   </li>
+ *   <li><b>setElementProperties(name, properties)</b><p style="margin-left:2.0em">Sets several properties of an element in the running pipeline together.<br>
+ *     Every value is converted and range checked before any is set, so an invalid value changes nothing, and property notifications are only sent once all are set.<br>
+ *     <b>name</b> Name of the element.<br>
+ *     <b>properties</b> Map of property name to value, converted as with setElementProperty.
+ *     </p>
+ *   </li>
+ *   <li><b>seek(format, position, rate, flags)</b><p style="margin-left:2.0em">Seeks the pipeline, for skimming through recordings at a given rate. Also available as a slot.<br>
+ *     <b>format</b> Can be "DEFAULT", "BYTES", "TIME", "BUFFERS" or "PERCENT"<br>
+ *     <b>position</b> Position to seek to. With a negative rate, playback runs backwards from here.
+ *     A negative position keeps the current position, to only change the rate.<br>
+ *     <b>rate</b> Playback rate, e.g. 8.0 for fast forward or -1.0 for rewind. Can not be 0.<br>
+ *     <b>flags</b> List of seek flags: "FLUSH", "ACCURATE", "KEY_UNIT", "SEGMENT", "SNAP_BEFORE", "SNAP_AFTER", "SNAP_NEAREST",
+ *     "TRICKMODE", "TRICKMODE_KEY_UNITS" or "TRICKMODE_NO_AUDIO". e.g. ["FLUSH", "KEY_UNIT", "TRICKMODE"] for fast forward on key frames.
+ *     In loop mode "SEGMENT" is always added, so the stream keeps looping.
+ *     </p>
+ *   </li>
+ *   <li><b>setStreamType_&lt;port&gt;(type)</b><p style="margin-left:2.0em">Sets how the appsrc of an input port is read, takes effect on activation.<br>
+ *     <b>type</b> "STREAM" (default), data is pushed as it arrives, or "RANDOM_ACCESS", every byte received is kept and GStreamer can seek in it,
+ *     e.g. to demux an MP4 file with the moov atom at the end. The stream size is known once a packet with EOS metadata is received.
+ *     </p>
+ *   </li>
+ *   <li><b>setBackingFile_&lt;port&gt;(fileName)</b><p style="margin-left:2.0em">In RANDOM_ACCESS mode, serve the appsrc from this memory mapped file instead of the input port.
+ *     Empty for the input port.</p>
+ *   </li>
  *   <li><b>getPipelineGraph()</b><p style="margin-left:2.0em">Returns a graph of the pipeline and its state as a string in dot format used by <a href="https://www.graphviz.org">Graphviz</a>.</p></li>
  *   <li><b>savePipelineGraph(fileName)</b><p style="margin-left:2.0em">Saves a graph of the GStreamer pipeline and its state in dot format to a given file.<br>
  *     <b>fileName</b> File name to save the graph to in dot file format.
@@ -35,6 +108,10 @@
  * <p>Ports from Pothos to GStreamer are added by specifying a <strong>appsrc name=appsrc_name</strong> at the start of the pipeline or<br>
  * from GStreamer to Pothos by specifying a <strong>appsink name=appsink_name</strong> at the end of the pipeline.</p>
  * <p>The name argument in the pipeline is used to identify the GStreamer block and will be used to name the Pothos port that is linked to that block.</p>
+ * <p>When every appsrc and appsink is given a name the ports are found from the description alone and the pipeline is only created when the block is activated.
+ * The plugins of the elements used are then loaded in the background until activation.</p>
+ * <p>GStreamer is initialized when the first block is created. Set the POTHOS_GSTREAMER_PRELOAD environment variable to
+ * a comma separated list of element factory names to have their plugins loaded in the background straight after.</p>
  *
  * Examples
  * <ul>
@@ -50,6 +127,148 @@
  * </ul>
  * |default "appsrc name=in ! appsink name=out"
  *
+ * |param declaredAppSrcs[Declared appsrc] Names of appsrc elements to create input ports for up front.
+ * <p>Use for appsrc elements that are not in the top level description, or only get added to the pipeline once it has started,
+ * such as elements inside a bin created by an auto plugging element.
+ * The port is bound to the element when it is added to the pipeline.</p>
+ * |default []
+ * |preview disable
+ *
+ * |param declaredAppSinks[Declared appsink] Names of appsink elements to create output ports for up front.
+ * <p>Use for appsink elements that are not in the top level description, or only get added to the pipeline once it has started,
+ * such as the sink of a decodebin or playbin.
+ * The port is bound to the element when it is added to the pipeline.</p>
+ * |default []
+ * |preview disable
+ *
+ * |param stateChangeTimeout[State Change Timeout] Maximum time a pipeline state change may take.
+ * <p>When set the state change is done on a GStreamer thread, so a blocking element can not hang the topology,
+ * and an asynchronous state change must complete (ASYNC_DONE) within this time.
+ * Pipelines fed from an appsrc must get their preroll data within this time.
+ * On timeout a "state-change-timeout" message is sent on the bus signal and the pipeline is torn down.</p>
+ * <p>0 disables the timeout, the state is then changed in the calling thread.</p>
+ * |units ms
+ * |default 0
+ * |preview disable
+ *
+ * |param activationMode[Activation Mode] How the pipeline is started when the topology is activated.
+ * <ul>
+ *   <li>"DIRECT" - Change straight to the requested state</li>
+ *   <li>"PREROLL" - Preroll in PAUSED first, filling appsrc queues from the Pothos inputs,
+ *       then change to PLAYING once the pipeline and every appsrc and appsink is ready.
+ *       Live pipelines, that can not preroll, change to PLAYING straight away.</li>
+ * </ul>
+ * |default "DIRECT"
+ * |option [Direct] "DIRECT"
+ * |option [Preroll] "PREROLL"
+ * |preview disable
+ *
+ * |param probeRate[Probe Rate] Rate the pipeline latency, position and duration are sampled at for their probes.
+ * <p>When set, getPipelineLatency(), getPipelinePosition() and getPipelineDuration() return the last values
+ * sampled from a background thread, instead of querying the pipeline from the caller's thread.</p>
+ * <p>0 disables sampling, the pipeline is then queried on every call.</p>
+ * |units Hz
+ * |default 0.0
+ * |preview disable
+ *
+ * |param loop[Loop] Restart the stream from the start when it ends, instead of stopping.
+ * <p>Once the pipeline has prerolled it is switched to segment playback, at the end of each segment a seek back to the start is queued up,
+ * so there is no gap and the pipeline and ports keep running. Sources that can not do segment seeks are restarted with a flushing seek on EOS.
+ * Streams that can not seek at all stop as without looping.
+ * The rate and flags of the last seek() are kept for the following loops, with a negative rate each loop restarts from the end.</p>
+ * |default false
+ * |option [Disabled] false
+ * |option [Enabled] true
+ * |preview disable
+ *
+ * |param offlineMode[Offline Mode] Process as fast as possible, instead of in real time.
+ * <p>For processing files: the pipeline is run without a clock, clock sync is disabled on every sink and appsink,
+ * and appsrc elements are made non-live and do not time stamp buffers, time stamps given in the packet metadata are kept.
+ * Use getProcessingSpeed() to see how much faster than real time it runs.</p>
+ * |default false
+ * |option [Disabled] false
+ * |option [Enabled] true
+ * |preview disable
+ *
+ * |param replicas[Replicas] Number of copies of the pipeline to run side by side, to spread the work over several cores.
+ * <p>For pipelines with one appsrc and one appsink whose elements do not thread internally, e.g. software encoders,
+ * when every input packet is an independent chunk that gives exactly one output packet, such as an image or a segment to transcode.
+ * Each copy runs in its own bin, input packets are handed out round robin, or by replicaKey, and the output packets are put back in input order.
+ * A packet is held back while the copy it goes to is full.</p>
+ * <p>1 runs the pipeline as given.</p>
+ * |default 1
+ * |preview disable
+ *
+ * |param replicaKey[Replica Key] Packet metadata key to pick the replica by.
+ * <p>Packets with the same value for this key always go to the same replica, e.g. so a stream id stays with one encoder.
+ * Packets without the key, or when empty, are handed out round robin.</p>
+ * |default ""
+ * |preview disable
+ *
+ * |param clockDomain[Clock Domain] Name of a clock shared with the other GStreamer blocks in the process.
+ * <p>Blocks with the same clock domain use the same clock and base time, so their running times line up,
+ * e.g. audio and video captured in separate blocks get time stamps that can be compared without resampling.
+ * The pipeline then does not pick a clock of its own, also not when it loses its clock.</p>
+ * <p>The base time is taken when the first block of the domain activates. Meant for live pipelines, whose sources time stamp
+ * buffers from the clock: a non-live pipeline joining later starts its time stamps from zero, so a sink syncing to the clock
+ * finds its buffers late by the time since, and drops them.</p>
+ * <p>Empty for a clock of its own. Not used in offline mode.</p>
+ * |default ""
+ * |preview disable
+ *
+ * |param streamingCpus[Streaming CPUs] CPUs the GStreamer streaming threads of the pipeline may run on, e.g. [2, 3].
+ * <p>Keeps heavy pipelines off the cores used by the Pothos worker threads.
+ * Applied to each streaming thread as it starts, from its stream status message. Only supported on Linux.</p>
+ * <p>Empty leaves the threads on any CPU.</p>
+ * |default []
+ * |preview disable
+ *
+ * |param streamingNice[Streaming Nice] Nice level of the GStreamer streaming threads of the pipeline.
+ * <p>Lowering it below that of the process needs privileges. Only supported on Linux.</p>
+ * <p>0 leaves the nice level as is.</p>
+ * |default 0
+ * |preview disable
+ *
+ * |param statsInterval[Stats Interval] How often the port stats are sent on the "portStats" signal, as returned by getPortStats(),
+ * and with tracers enabled the tracer stats on the "tracerStats" signal.
+ * <p>0 disables the signal, the stats are still kept for the probe.</p>
+ * |units seconds
+ * |default 0.0
+ * |preview disable
+ *
+ * |param measureLatency[Measure Latency] Measure how long buffers take from an appsrc to an appsink.
+ * <p>Each buffer pushed into an appsrc is stamped with the time in a GstMeta, which elements carry over to the buffers they make from it.
+ * Output packets of buffers that have the stamp get their latency in ns in the "latency" metadata,
+ * and the percentiles per port are given by getLatencyStats().</p>
+ * |default false
+ * |option [Disabled] false
+ * |option [Enabled] true
+ * |preview disable
+ *
+ * |param metadataMode[Metadata Mode] How much metadata goes with each buffer.
+ * <ul>
+ *   <li>"FULL" - Output packets have the time stamps, offsets, flags, caps and metadata of the buffer</li>
+ *   <li>"MINIMAL" - Output packets only have their payload, the caps when they change and EOS.
+ *   Input packets are wrapped in pooled blocks, so that once running the block makes no heap allocations per buffer of its own, as checked by ctest.
+ *   Still allocated for each buffer are the GstBuffer, GstMemory and GstSample, by GLib,
+ *   and the message container the framework makes for each packet posted. Measuring latency also adds metadata to each packet.</li>
+ * </ul>
+ * |default "FULL"
+ * |option [Full] "FULL"
+ * |option [Minimal] "MINIMAL"
+ * |preview disable
+ *
+ * |param tracers[Tracers] GStreamer tracers to enable, for getTracerStats(), e.g. ["latency", "rusage"].
+ * <ul>
+ *   <li>"latency" - Latency through each element and the pipeline</li>
+ *   <li>"stats" - Buffers and bytes pushed by each element</li>
+ *   <li>"rusage" - CPU load of the process</li>
+ * </ul>
+ * <p>Tracers are global to GStreamer: once enabled on activation they stay enabled for the whole process, as if set with GST_TRACERS,
+ * and slow down every pipeline. Their records are taken out of the debug log while a block with tracers exists, each block keeps those about its own elements.</p>
+ * |default []
+ * |preview disable
+ *
  * |param state[State] Changes the state of the pipeline
  * <ul>
  *   <li>"PLAY" - Start the pipeline playing</li>
@@ -62,10 +281,33 @@
  *
  * |factory /media/gstreamer(pipelineString)
  * |setter setState(state)
+ * |setter declareAppSrcs(declaredAppSrcs)
+ * |setter declareAppSinks(declaredAppSinks)
+ * |setter setStateChangeTimeout(stateChangeTimeout)
+ * |setter setActivationMode(activationMode)
+ * |setter setProbeRate(probeRate)
+ * |setter setLoop(loop)
+ * |setter setOfflineMode(offlineMode)
+ * |setter setReplicas(replicas)
+ * |setter setReplicaKey(replicaKey)
+ * |setter setClockDomain(clockDomain)
+ * |setter setStreamingCpus(streamingCpus)
+ * |setter setStreamingNice(streamingNice)
+ * |setter setStatsInterval(statsInterval)
+ * |setter setMeasureLatency(measureLatency)
+ * |setter setMetadataMode(metadataMode)
+ * |setter setTracers(tracers)
  **********************************************************************/
 
 #include "GStreamer.hpp"
+#include "GStreamerBinSwap.hpp"
+#include "GStreamerElementTiming.hpp"
+#include "GStreamerPipelineDescription.hpp"
+#include "GStreamerPipelineSampler.hpp"
+#include "GStreamerReplicas.hpp"
 #include "GStreamerStatic.hpp"
+#include "GStreamerThreadPolicy.hpp"
+#include "GStreamerTracerStats.hpp"
 #include "GStreamerToPothos.hpp"
 #include "GStreamerTypes.hpp"
 #include "PothosToGStreamer.hpp"
@@ -73,9 +315,13 @@
 #include <Pothos/Exception.hpp>
 #include <Pothos/Framework.hpp>
 #include <Poco/String.h>
+#include <Poco/StringTokenizer.h>
 #include <gst/gst.h>
 #include <iostream>
+#include <algorithm>
 #include <fstream>
+#include <future>
+#include <memory>
 #include <sstream>
 #include <vector>
 #include <utility>
@@ -83,6 +329,8 @@
 const char SIGNAL_BUS_NAME[]{ "bus"    };
 const char SIGNAL_TAG     []{ "busTag" };
 const char SIGNAL_EOS_NAME[]{ "eos"    };
+const char SIGNAL_PORT_STATS[]{ "portStats" };
+const char SIGNAL_TRACER_STATS[]{ "tracerStats" };
 
 static const auto PIPELINE_GRAPH_DETAILS = GST_DEBUG_GRAPH_SHOW_VERBOSE;
 
@@ -91,41 +339,136 @@ GStreamer::GStreamer(const std::string &pipelineString) :
     m_pipeline( ),
     m_bus( ),
     m_gstreamerSubWorkers( ),
-    m_blockingNodes( 0 ),
     m_pipelineActive( false ),
-    m_gstState( GST_STATE_PLAYING )
+    m_gstState( GST_STATE_PLAYING ),
+    m_elementAdded( false ),
+    m_stateChangeTimeoutMs( 0 ),
+    m_asyncStatePending( false ),
+    m_asyncTargetState( GST_STATE_VOID_PENDING ),
+    m_asyncStateDeadline( ),
+    m_pendingBusSignals( ),
+    m_prerollActivation( false ),
+    m_prerolling( false ),
+    m_stateSettled( false ),
+    m_livePipeline( false ),
+    m_probeRateHz( 0.0 ),
+    m_pipelineSampler( ),
+    m_waker( std::make_shared< GstStatic::Waker >() ),
+    m_teardownDurationNs( 0 ),
+    m_propertyElements( ),
+    m_paramSpecs( ),
+    m_loop( false ),
+    m_loopStarted( false ),
+    m_loopCount( 0 ),
+    m_loopRate( 1.0 ),
+    m_loopSeekFlags( GST_SEEK_FLAG_NONE ),
+    m_offlineMode( false ),
+    m_playingTime( ),
+    m_loopedNs( 0 ),
+    m_replicas( 1 ),
+    m_replicaKey( ),
+    m_clockDomainName( ),
+    m_clockDomain( ),
+    m_streamingCpus( ),
+    m_streamingNice( 0 ),
+    m_threadPolicy( ),
+    m_statsInterval( 0 ),
+    m_lastStatsTime( ),
+    m_measureLatency( false ),
+    m_minimalMetadata( false ),
+    m_tracers( ),
+    m_tracerStats( ),
+    m_elementTimingEnabled( false ),
+    m_timedElements( ),
+    m_elementTiming( ),
+    m_readySubWorkers( ),
+    m_readyOccupancy( )
 {
-    if ( GstStatic::getInitError() != nullptr )
+    // GStreamer is initialized when the first block is created
+    if ( GstStatic::init() != nullptr )
     {
         throw Pothos::RuntimeException( "GStreamer::GStreamer()", "Could not initialize GStreamer library: " + GstTypes::gerrorToString( GstStatic::getInitError() ) );
     }
 
     poco_information( GstTypes::logger(), "GStreamer version: " + GstStatic::getVersion() );
 
-    poco_information( GstTypes::logger(), "About to create pipeline: " + m_pipeline_string );
+    // Try to find AppSink(s) and AppSource(s) without creating the pipeline.
+    // The pipeline is then only created when the block is activated.
+    const auto description = GstPipelineDescription::parse( m_pipeline_string );
+    if ( description.isSpecified() )
+    {
+        // Load the plugins in the background while the topology is being built
+        GstStatic::preload( description.value().factories );
+
+        createSubWorkers( description.value() );
+    }
+    else
+    {
+        poco_information( GstTypes::logger(), "About to create pipeline to find ports: " + m_pipeline_string );
 
-    // Try to create GStreamer pipeline from given string
-    createPipeline();
+        // Try to create GStreamer pipeline from given string
+        createPipeline();
 
-    // Iterate through pipeline and try and find AppSink(s) and AppSource(s)
-    findSourcesAndSinks( GST_BIN( m_pipeline.get() ) );
+        // Iterate through pipeline and try and find AppSink(s) and AppSource(s)
+        findSourcesAndSinks( GST_BIN( m_pipeline.get() ) );
+    }
 
     this->registerSignal( SIGNAL_BUS_NAME );
     this->registerSignal( SIGNAL_TAG );
     this->registerSignal( SIGNAL_EOS_NAME );
+    this->registerSignal( SIGNAL_PORT_STATS );
+    this->registerSignal( SIGNAL_TRACER_STATS );
 
     this->registerCall(this, POTHOS_FCN_TUPLE(GStreamer, getPipelineString));
     this->registerCall(this, POTHOS_FCN_TUPLE(GStreamer, setState));
+    this->registerCall(this, POTHOS_FCN_TUPLE(GStreamer, declareAppSrcs));
+    this->registerCall(this, POTHOS_FCN_TUPLE(GStreamer, declareAppSinks));
+    this->registerCall(this, POTHOS_FCN_TUPLE(GStreamer, setStateChangeTimeout));
+    this->registerCall(this, POTHOS_FCN_TUPLE(GStreamer, setActivationMode));
+    this->registerCall(this, POTHOS_FCN_TUPLE(GStreamer, setProbeRate));
+    this->registerCall(this, POTHOS_FCN_TUPLE(GStreamer, setLoop));
+    this->registerCall(this, POTHOS_FCN_TUPLE(GStreamer, setOfflineMode));
+    this->registerCall(this, POTHOS_FCN_TUPLE(GStreamer, setReplicas));
+    this->registerCall(this, POTHOS_FCN_TUPLE(GStreamer, setReplicaKey));
+    this->registerCall(this, POTHOS_FCN_TUPLE(GStreamer, setClockDomain));
+    this->registerCall(this, POTHOS_FCN_TUPLE(GStreamer, setStreamingCpus));
+    this->registerCall(this, POTHOS_FCN_TUPLE(GStreamer, setStreamingNice));
+    this->registerCall(this, POTHOS_FCN_TUPLE(GStreamer, getStreamingThreadCount));
+    this->registerCall(this, POTHOS_FCN_TUPLE(GStreamer, setStatsInterval));
+    this->registerCall(this, POTHOS_FCN_TUPLE(GStreamer, getPortStats));
+    this->registerCall(this, POTHOS_FCN_TUPLE(GStreamer, setMeasureLatency));
+    this->registerCall(this, POTHOS_FCN_TUPLE(GStreamer, getLatencyStats));
+    this->registerCall(this, POTHOS_FCN_TUPLE(GStreamer, setMetadataMode));
+    this->registerCall(this, POTHOS_FCN_TUPLE(GStreamer, setTracers));
+    this->registerCall(this, POTHOS_FCN_TUPLE(GStreamer, getTracerStats));
+    this->registerCall(this, POTHOS_FCN_TUPLE(GStreamer, enableElementTiming));
+    this->registerCall(this, POTHOS_FCN_TUPLE(GStreamer, disableElementTiming));
+    this->registerCall(this, POTHOS_FCN_TUPLE(GStreamer, getElementTiming));
+    this->registerCall(this, POTHOS_FCN_TUPLE(GStreamer, getProcessingSpeed));
+    this->registerCall(this, POTHOS_FCN_TUPLE(GStreamer, getLoopCount));
     this->registerCall(this, POTHOS_FCN_TUPLE(GStreamer, getPipeline));
     this->registerCall(this, POTHOS_FCN_TUPLE(GStreamer, getPipelineLatency));
     this->registerCall(this, POTHOS_FCN_TUPLE(GStreamer, getPipelinePosition));
     this->registerCall(this, POTHOS_FCN_TUPLE(GStreamer, getPipelineDuration));
     this->registerCall(this, POTHOS_FCN_TUPLE(GStreamer, getPipelineGraph));
     this->registerCall(this, POTHOS_FCN_TUPLE(GStreamer, savePipelineGraph));
+    this->registerCall(this, POTHOS_FCN_TUPLE(GStreamer, getTeardownDuration));
+    this->registerCall(this, POTHOS_FCN_TUPLE(GStreamer, replaceBin));
+    this->registerCall(this, POTHOS_FCN_TUPLE(GStreamer, seek));
+    this->registerCall(this, POTHOS_FCN_TUPLE(GStreamer, setElementProperty));
+    this->registerCall(this, POTHOS_FCN_TUPLE(GStreamer, setElementProperties));
 
     this->registerProbe("getPipelineLatency");
     this->registerProbe("getPipelinePosition");
     this->registerProbe("getPipelineDuration");
+    this->registerProbe("getTeardownDuration");
+    this->registerProbe("getLoopCount");
+    this->registerProbe("getProcessingSpeed");
+    this->registerProbe("getStreamingThreadCount");
+    this->registerProbe("getPortStats");
+    this->registerProbe("getLatencyStats");
+    this->registerProbe("getTracerStats");
+    this->registerProbe("getElementTiming");
 }
 
 GStreamer::~GStreamer()
@@ -147,7 +490,23 @@ Pothos::Block *GStreamer::make(const std::string &pipelineString)
 
 GstTypes::GstElementPtr GStreamer::getPipelineElementByName(const std::string &name) const
 {
-    return GstTypes::GstElementPtr( gst_bin_get_by_name( GST_BIN( getPipeline() ), name.c_str() ) );
+    if ( !m_pipeline )
+    {
+        return nullptr;
+    }
+
+    // A path of bin names picks one of the elements of the same name in different bins, e.g. "replica1/encoder"
+    GstTypes::GstElementPtr element( GST_ELEMENT( gst_object_ref( m_pipeline.get() ) ) );
+    Poco::StringTokenizer path( name, "/" );
+    for (const auto &pathName : path)
+    {
+        if ( !element || !GST_IS_BIN( element.get() ) )
+        {
+            return nullptr;
+        }
+        element.reset( gst_bin_get_by_name( GST_BIN( element.get() ), pathName.c_str() ) );
+    }
+    return element;
 }
 
 template< class Fn>
@@ -168,10 +527,11 @@ GstIteratorResult gstIteratorForeach(GstIterator* gstIterator, Fn f)
 void GStreamer::findSourcesAndSinks(GstBin *bin)
 {
     const std::string funcName("GStreamer::findSourcesAndSinks(GstBin *bin)");
-    GstTypes::GstIteratorPtr gstIterator( gst_bin_iterate_elements( bin ) );
+    // Recurse into child bins so AppSink(s) and AppSource(s) inside them become ports too
+    GstTypes::GstIteratorPtr gstIterator( gst_bin_iterate_recurse( bin ) );
     if ( gstIterator.get() == nullptr )
     {
-        throw Pothos::RuntimeException( funcName, "gst_bin_iterate_elements returned null" );
+        throw Pothos::RuntimeException( funcName, "gst_bin_iterate_recurse returned null" );
     }
 
     auto forEachElement = [ this ] (const GValue *value)
@@ -218,15 +578,6 @@ void GStreamer::findSourcesAndSinks(GstBin *bin)
         case GST_ITERATOR_OK:
         case GST_ITERATOR_DONE:
         {
-            // Count how many blocking sub workers we have for timing
-            m_blockingNodes = 0;
-            for (auto &subWorker : m_gstreamerSubWorkers )
-            {
-                if ( subWorker->blocking() )
-                {
-                    ++m_blockingNodes;
-                }
-            }
             return;
         }
         default:
@@ -234,13 +585,202 @@ void GStreamer::findSourcesAndSinks(GstBin *bin)
     }
 }
 
+void GStreamer::createSubWorkers(const GstPipelineDescription::Description &description)
+{
+    for (const auto &name : description.appSrcNames)
+    {
+        m_gstreamerSubWorkers.push_back( PothosToGStreamer::make( this, name ) );
+    }
+
+    for (const auto &name : description.appSinkNames)
+    {
+        m_gstreamerSubWorkers.push_back( GStreamerToPothos::make( this, name ) );
+    }
+
+}
+
+bool GStreamer::hasSubWorker(const std::string &name) const
+{
+    for (const auto &subWorker : m_gstreamerSubWorkers)
+    {
+        if ( subWorker->name() == name )
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+void GStreamer::declareAppSrcs(const std::vector< std::string > &names)
+{
+    for (const auto &name : names)
+    {
+        // Ports already found in the description or declared earlier are kept as is
+        if ( hasSubWorker( name ) )
+        {
+            continue;
+        }
+        auto subWorker = PothosToGStreamer::make( this, name );
+        subWorker->setDeclared( true );
+        m_gstreamerSubWorkers.push_back( std::move( subWorker ) );
+    }
+}
+
+void GStreamer::declareAppSinks(const std::vector< std::string > &names)
+{
+    for (const auto &name : names)
+    {
+        // Ports already found in the description or declared earlier are kept as is
+        if ( hasSubWorker( name ) )
+        {
+            continue;
+        }
+        auto subWorker = GStreamerToPothos::make( this, name );
+        subWorker->setDeclared( true );
+        m_gstreamerSubWorkers.push_back( std::move( subWorker ) );
+    }
+}
+
+/**
+ * @brief Called from GStreamer when an element is added anywhere in the pipeline, may be a streaming thread.
+ */
+void GStreamer::deepElementAdded(GstBin * /* bin */, GstBin * /* subBin */, GstElement *element, gpointer userData)
+{
+    auto self = static_cast< GStreamer* >( userData );
+    if ( self->m_offlineMode )
+    {
+        disableSinkSync( element );
+    }
+    if ( self->m_tracerStats )
+    {
+        self->m_tracerStats->addElement( element );
+    }
+    self->m_elementAdded = true;
+}
+
+/**
+ * @brief Let a sink render as soon as it gets data, instead of waiting for the clock.
+ */
+void GStreamer::disableSinkSync(GstElement *element)
+{
+    if ( GST_OBJECT_FLAG_IS_SET( element, GST_ELEMENT_FLAG_SINK ) &&
+         g_object_class_find_property( G_OBJECT_GET_CLASS( element ), "sync" ) != nullptr )
+    {
+        g_object_set( element, "sync", FALSE, nullptr );
+    }
+}
+
+/**
+ * @brief Set up the pipeline to run as fast as possible, with no clock and no sink syncing to one.
+ */
+void GStreamer::applyOfflineMode()
+{
+    GstTypes::GstIteratorPtr gstIterator( gst_bin_iterate_recurse( GST_BIN( m_pipeline.get() ) ) );
+    const auto gstIteratorRes = gstIteratorForeach( gstIterator.get(), [ ](const GValue *value)
+        {
+            disableSinkSync( GST_ELEMENT( g_value_get_object( value ) ) );
+        }
+    );
+    if ( gstIteratorRes != GST_ITERATOR_DONE )
+    {
+        poco_warning( GstTypes::logger(), "GStreamer::applyOfflineMode(): Could not iterate all elements, some sinks may still sync to the clock" );
+    }
+
+    gst_pipeline_use_clock( m_pipeline.get(), nullptr );
+}
+
+void GStreamer::bindDeclaredSubWorkers()
+{
+    for (auto &subWorker : m_gstreamerSubWorkers)
+    {
+        if ( subWorker->declared() && subWorker->bind() && GstTypes::debug_extra )
+        {
+            poco_information( GstTypes::logger(), "GStreamer::bindDeclaredSubWorkers() bound " + subWorker->name() );
+        }
+    }
+}
+
+/**
+ * @brief Sub workers with something to do, the fullest queue first.
+ * Sorted by insertion into member vectors, which stop allocating once they have grown to the number of sub workers.
+ */
+const std::vector< GStreamerSubWorker* >& GStreamer::readySubWorkers()
+{
+    m_readySubWorkers.clear();
+    m_readyOccupancy.clear();
+    for (const auto &subWorker : m_gstreamerSubWorkers)
+    {
+        const auto occupancy = subWorker->occupancy();
+        if ( occupancy > 0.0 )
+        {
+            // After those as full or fuller, keeping the order of equals
+            size_t index = m_readyOccupancy.size();
+            while ( index > 0 && m_readyOccupancy[ index - 1 ] < occupancy )
+            {
+                --index;
+            }
+            m_readyOccupancy.insert( m_readyOccupancy.begin() + static_cast< std::ptrdiff_t >( index ), occupancy );
+            m_readySubWorkers.insert( m_readySubWorkers.begin() + static_cast< std::ptrdiff_t >( index ), subWorker.get() );
+        }
+    }
+    return m_readySubWorkers;
+}
+
+/**
+ * @brief Called from the thread posting the message, wakes the block for every message on the bus.
+ */
+GstBusSyncReply GStreamer::busSyncHandler(GstBus * /* bus */, GstMessage *message, gpointer userData)
+{
+    auto self = static_cast< GStreamer* >( userData );
+    // Set and reset by the block thread while streaming threads post messages
+    const auto threadPolicy = std::atomic_load( &self->m_threadPolicy );
+    if ( threadPolicy )
+    {
+        threadPolicy->handleMessage( message );
+    }
+    self->m_waker->notify();
+    return GST_BUS_PASS;
+}
+
+/**
+ * @brief Make a pipeline holding a copy of the description per replica, each in its own bin so the element names don't clash.
+ */
+GstElement* GStreamer::createReplicaPipeline()
+{
+    const std::string funcName("GStreamer::createReplicaPipeline");
+
+    if ( m_gstreamerSubWorkers.size() != 1 )
+    {
+        throw Pothos::InvalidArgumentException( funcName, "Replicas can not be used with declared appsrc or appsink elements" );
+    }
+
+    GstTypes::GstElementPtr pipeline( GST_ELEMENT( gst_object_ref_sink( gst_pipeline_new( nullptr ) ) ) );
+    for (size_t index = 0; index < m_replicas; ++index)
+    {
+        GstTypes::GErrorPtr errorPtr;
+        GstElement *bin = gst_parse_bin_from_description_full(
+            m_pipeline_string.c_str(), FALSE, nullptr, GST_PARSE_FLAG_FATAL_ERRORS, GstTypes::uniqueOutArg( errorPtr )
+        );
+        if ( bin == nullptr )
+        {
+            throw Pothos::InvalidArgumentException( funcName, "Failed to parse pipeline ( " + m_pipeline_string + " ). Error: " + GstTypes::gerrorToString( errorPtr.get() ) );
+        }
+
+        gst_object_set_name( GST_OBJECT( bin ), GStreamerReplicas::binName( index ).c_str() );
+        gst_bin_add( GST_BIN( pipeline.get() ), bin );
+    }
+    return pipeline.release();
+}
+
 void GStreamer::createPipeline()
 {
     const std::string funcName("GStreamer::createPipeline");
 
     GstTypes::GErrorPtr errorPtr;
     GstTypes::GstElementPtr element(
-        gst_parse_launch_full( m_pipeline_string.c_str(), nullptr, GST_PARSE_FLAG_FATAL_ERRORS, GstTypes::uniqueOutArg(errorPtr) )
+        ( m_replicas > 1 ) ?
+            createReplicaPipeline() :
+            gst_parse_launch_full( m_pipeline_string.c_str(), nullptr, GST_PARSE_FLAG_FATAL_ERRORS, GstTypes::uniqueOutArg(errorPtr) )
     );
 
     const std::string errorMessage( GstTypes::gerrorToString( errorPtr.get() ) );
@@ -267,6 +807,9 @@ void GStreamer::createPipeline()
 
     m_pipeline.reset( reinterpret_cast< GstPipeline* >( element.release() ) );
 
+    // Get notified of elements added later on, so declared sub workers can be bound to them
+    g_signal_connect( m_pipeline.get(), "deep-element-added", G_CALLBACK( &GStreamer::deepElementAdded ), this );
+
     m_bus.reset( gst_pipeline_get_bus( m_pipeline.get() ) );
     if ( !m_bus )
     {
@@ -275,6 +818,7 @@ void GStreamer::createPipeline()
 
         throw Pothos::RuntimeException( funcName, "Failed to get bus for GStreamer pipeline." );
     }
+    gst_bus_set_sync_handler( m_bus.get(), &GStreamer::busSyncHandler, this, nullptr );
 }
 
 void GStreamer::destroyPipeline()
@@ -284,6 +828,20 @@ void GStreamer::destroyPipeline()
         return;
     }
 
+    const auto teardownStart = std::chrono::steady_clock::now();
+
+    g_signal_handlers_disconnect_by_data( m_pipeline.get(), this );
+
+    // Stop sampling before the pipeline goes away
+    m_pipelineSampler.reset();
+
+    if ( m_elementTiming )
+    {
+        m_elementTiming->detach();
+    }
+
+    m_propertyElements.clear();
+
     std::exception_ptr exceptionPtr;
     try
     {
@@ -296,17 +854,30 @@ void GStreamer::destroyPipeline()
         exceptionPtr = std::current_exception();
     }
 
+    // Swaps that never got data hold references on the pipeline
+    GstBinSwap::cancel( m_pipeline.get() );
+
     if ( m_bus )
     {
         // Process any GStreamer messages left on the bus so we can print any errors.
-        processGstMessagesTimeout( 100 * GST_MSECOND );
+        // Changing to NULL is synchronous, so everything of interest is already on the bus.
+        drainGstMessages();
 
         // Free Bus
+        gst_bus_set_sync_handler( m_bus.get(), nullptr, nullptr, nullptr );
         m_bus.reset();
+        std::atomic_store( &m_threadPolicy, std::shared_ptr< GStreamerThreadPolicy >() );
     }
 
     // Free GStreamer pipeline
     m_pipeline.reset();
+    m_clockDomain.reset();
+
+    m_teardownDurationNs = std::chrono::duration_cast< std::chrono::nanoseconds >( std::chrono::steady_clock::now() - teardownStart ).count();
+    if ( GstTypes::debug_extra )
+    {
+        poco_information( GstTypes::logger(), "GStreamer::destroyPipeline() took " + std::to_string( m_teardownDurationNs ) + "ns" );
+    }
 
     if ( exceptionPtr )
     {
@@ -389,49 +960,422 @@ static Pothos::ObjectKwargs clockInfo(GstClock *clock)
     return objectMsgMap;
 }
 
-void GStreamer::workerStop(const std::string & reason)
+/**
+ * @brief Segment seek over the whole stream, at the rate and with the flags of the last seek().
+ * @param flush Flush the pipeline, or queue the seek up behind the current segment
+ * @return true if seeking succeeded
+ */
+bool GStreamer::segmentSeek(bool flush)
 {
-    // Stop pipeline if there was an error
-    m_pipelineActive = false;
+    const auto flags = static_cast< GstSeekFlags >( m_loopSeekFlags | GST_SEEK_FLAG_SEGMENT | ( flush ? GST_SEEK_FLAG_FLUSH : GST_SEEK_FLAG_NONE ) );
+    if ( m_loopRate > 0.0 )
+    {
+        return gst_element_seek( GST_ELEMENT( m_pipeline.get() ), m_loopRate, GST_FORMAT_TIME, flags,
+                                 GST_SEEK_TYPE_SET, 0, GST_SEEK_TYPE_NONE, GST_CLOCK_TIME_NONE ) == TRUE;
+    }
 
-    poco_warning( GstTypes::logger(), "Pipeline has stopped, reason: " + reason + ". This block will do nothing for the remainder of this running topology" );
+    // Going backwards, every loop plays from the end back to the start
+    const auto duration = GstPipelineQuery::duration( GST_ELEMENT( m_pipeline.get() ), GST_FORMAT_TIME );
+    if ( !duration.isSpecified() )
+    {
+        return false;
+    }
+    return gst_element_seek( GST_ELEMENT( m_pipeline.get() ), m_loopRate, GST_FORMAT_TIME, flags,
+                             GST_SEEK_TYPE_SET, 0, GST_SEEK_TYPE_SET, duration.value() ) == TRUE;
 }
 
-Pothos::ObjectKwargs GStreamer::gstMessageToFormattedObject(GstMessage *gstMessage)
+/**
+ * @brief Seek back to the start of the stream, for loop mode.
+ * @param flush Flush the pipeline, needed after EOS, or queue the seek up behind the current segment after SEGMENT_DONE
+ * @param loopEndNs Stream time the loop ended at, kept for getProcessingSpeed() as the position starts over
+ * @return true if seeking succeeded
+ */
+bool GStreamer::loopSeek(bool flush, Poco::Optional< int64_t > loopEndNs)
 {
-    switch ( gstMessage->type )
+    const auto seeked = segmentSeek( flush );
+    if ( seeked )
     {
-        case GST_MESSAGE_WARNING:
+        ++m_loopCount;
+        m_loopedNs += std::max< int64_t >( loopEndNs.value( 0 ), 0 );
+    }
+    else
+    {
+        poco_warning( GstTypes::logger(), "GStreamer::loopSeek(): Could not seek back to the start of the stream" );
+    }
+    return seeked;
+}
+
+void GStreamer::setOfflineMode(bool enable)
+{
+    m_offlineMode = enable;
+}
+
+bool GStreamer::offlineMode() const
+{
+    return m_offlineMode;
+}
+
+double GStreamer::getProcessingSpeed() const
+{
+    // From PLAYING, the time spent prerolling is not processing
+    if ( m_playingTime == std::chrono::steady_clock::time_point() )
+    {
+        throw Pothos::PropertyNotSupportedException( "GStreamer::getProcessingSpeed()", "Pipeline has not been playing" );
+    }
+    const auto position = m_loopedNs + getPipelinePosition( "TIME" );
+    const auto elapsed = std::chrono::duration_cast< std::chrono::nanoseconds >( std::chrono::steady_clock::now() - m_playingTime ).count();
+    if ( elapsed <= 0 )
+    {
+        throw Pothos::PropertyNotSupportedException( "GStreamer::getProcessingSpeed()", "Pipeline has just started playing" );
+    }
+    return static_cast< double >( position ) / static_cast< double >( elapsed );
+}
+
+void GStreamer::setReplicas(int replicas)
+{
+    const std::string funcName( "GStreamer::setReplicas(" + std::to_string( replicas ) + ")" );
+
+    if ( replicas < 1 )
+    {
+        throw Pothos::InvalidArgumentException( funcName, "Need at least one replica" );
+    }
+    if ( m_pipelineActive )
+    {
+        throw Pothos::RuntimeException( funcName, "Can not change the number of replicas of a running pipeline" );
+    }
+
+    const auto replicaSet = this->replicaSet();
+    if ( replicas > 1 && replicaSet == nullptr )
+    {
+        // The ports stay as they are, the replica set feeds every copy from them
+        std::string appSrcName;
+        std::string appSinkName;
+        const auto &inputs = this->inputs();
+        for (const auto &subWorker : m_gstreamerSubWorkers)
         {
-            return gstMessageInfoWarnError( gstMessage );
+            const auto isInput = std::any_of( inputs.cbegin(), inputs.cend(), [ &subWorker ](const Pothos::InputPort *input) { return input->name() == subWorker->name(); } );
+            ( isInput ? appSrcName : appSinkName ) = subWorker->name();
         }
-
-        case GST_MESSAGE_ERROR:
+        if ( m_gstreamerSubWorkers.size() != 2 || appSrcName.empty() || appSinkName.empty() )
         {
-            workerStop( "GStreamer Error" );
-            return gstMessageInfoWarnError( gstMessage );
+            throw Pothos::InvalidArgumentException( funcName, "Replicas need a pipeline with one appsrc and one appsink" );
         }
-
-        case GST_MESSAGE_INFO:
+        for (const auto &subWorker : m_gstreamerSubWorkers)
         {
-            return gstMessageInfoWarnError( gstMessage );
+            if ( !subWorker->canReplicate() )
+            {
+                throw Pothos::InvalidArgumentException( funcName, "\"" + subWorker->name() + "\" can not be replicated, e.g. a random access appsrc" );
+            }
         }
 
-        case GST_MESSAGE_STATE_CHANGED:
-        {
-            GstState old_state, new_state, pending;
+        std::unique_ptr< GStreamerSubWorker > replicaWorker( new GStreamerReplicas( this, std::move( m_gstreamerSubWorkers ), appSrcName, appSinkName ) );
+        m_gstreamerSubWorkers.clear();
+        m_gstreamerSubWorkers.push_back( std::move( replicaWorker ) );
+    }
+    else if ( replicas == 1 && replicaSet != nullptr )
+    {
+        auto ports = replicaSet->releasePorts();
+        m_gstreamerSubWorkers = std::move( ports );
+    }
 
-            gst_message_parse_state_changed( gstMessage, &old_state, &new_state, &pending );
+    if ( static_cast< size_t >( replicas ) != m_replicas )
+    {
+        m_replicas = static_cast< size_t >( replicas );
+        // A pipeline created to find the ports only has one copy
+        destroyPipeline();
+    }
+}
 
-            debugPipelineToDot( this->getName() + " " + gst_element_state_get_name(old_state) + " - " + gst_element_state_get_name(new_state) );
+size_t GStreamer::replicas() const
+{
+    return m_replicas;
+}
 
-            Pothos::ObjectKwargs objectMsgMap;
-            objectMsgMap[ "old_state" ] = GstTypes::gcharToObject( gst_element_state_get_name( old_state ) );
-            objectMsgMap[ "new_state" ] = GstTypes::gcharToObject( gst_element_state_get_name( new_state ) );
-            objectMsgMap[ "pending"   ] = GstTypes::gcharToObject( gst_element_state_get_name( pending ) );
+/**
+ * @brief The sub worker feeding the replicas, in place of the appsrc and appsink sub workers.
+ * @return nullptr if the pipeline is not replicated
+ */
+GStreamerReplicas* GStreamer::replicaSet() const
+{
+    return ( m_gstreamerSubWorkers.size() == 1 ) ? dynamic_cast< GStreamerReplicas* >( m_gstreamerSubWorkers.front().get() ) : nullptr;
+}
 
-            return objectMsgMap;
-        }
+void GStreamer::setClockDomain(const std::string &name)
+{
+    m_clockDomainName = name;
+}
+
+void GStreamer::setStreamingCpus(const std::vector< int > &cpus)
+{
+    for (const auto cpu : cpus)
+    {
+        if ( cpu < 0 )
+        {
+            throw Pothos::InvalidArgumentException( "GStreamer::setStreamingCpus(" + std::to_string( cpu ) + ")", "CPU can not be negative" );
+        }
+    }
+    m_streamingCpus = cpus;
+}
+
+void GStreamer::setStreamingNice(int nice)
+{
+    m_streamingNice = nice;
+}
+
+uint64_t GStreamer::getStreamingThreadCount() const
+{
+    const auto threadPolicy = std::atomic_load( &m_threadPolicy );
+    return ( threadPolicy ) ? threadPolicy->threadCount() : 0;
+}
+
+void GStreamer::setStatsInterval(double seconds)
+{
+    if ( seconds < 0.0 )
+    {
+        throw Pothos::InvalidArgumentException( "GStreamer::setStatsInterval(" + std::to_string( seconds ) + ")", "Interval can not be negative" );
+    }
+    m_statsInterval = std::chrono::duration_cast< std::chrono::nanoseconds >( std::chrono::duration< double >( seconds ) );
+}
+
+Pothos::ObjectKwargs GStreamer::getPortStats() const
+{
+    Pothos::ObjectKwargs stats;
+    for (const auto &subWorker : m_gstreamerSubWorkers)
+    {
+        subWorker->addPortStats( stats );
+    }
+    return stats;
+}
+
+void GStreamer::setMeasureLatency(bool enable)
+{
+    m_measureLatency = enable;
+}
+
+bool GStreamer::measureLatency() const
+{
+    return m_measureLatency;
+}
+
+void GStreamer::setMetadataMode(const std::string &mode)
+{
+    static constexpr std::array< std::pair< const char * const, bool >, 2 > modeOptions =
+    { {
+        { "FULL"    , false },
+        { "MINIMAL" , true  }
+    } };
+
+    try
+    {
+        m_minimalMetadata = GstTypes::findValueByKey( std::begin(modeOptions), std::end(modeOptions), mode );
+    }
+    catch (const Pothos::NotFoundException &e)
+    {
+        throw Pothos::InvalidArgumentException("GStreamer::setMetadataMode("+mode+")", e.message());
+    }
+}
+
+bool GStreamer::minimalMetadata() const
+{
+    return m_minimalMetadata;
+}
+
+Pothos::ObjectKwargs GStreamer::getLatencyStats() const
+{
+    Pothos::ObjectKwargs latencyStats;
+    for (const auto &port : getPortStats())
+    {
+        const auto &stats = port.second.extract< Pothos::ObjectKwargs >();
+        const auto latency_it = stats.find( "latency" );
+        if ( latency_it != stats.end() )
+        {
+            latencyStats[ port.first ] = latency_it->second;
+        }
+    }
+    return latencyStats;
+}
+
+void GStreamer::setTracers(const std::vector< std::string > &tracers)
+{
+    const auto &supported = GStreamerTracerStats::supportedTracers();
+    for (const auto &tracer : tracers)
+    {
+        if ( std::find( supported.begin(), supported.end(), tracer ) == supported.end() )
+        {
+            throw Pothos::InvalidArgumentException( "GStreamer::setTracers(" + tracer + ")", "Unknown tracer" );
+        }
+    }
+    m_tracers = tracers;
+}
+
+/**
+ * @brief Enable the tracers and collect their records about the elements of the pipeline.
+ */
+void GStreamer::startTracerStats()
+{
+    if ( m_tracers.empty() )
+    {
+        return;
+    }
+
+    GStreamerTracerStats::enable( m_tracers );
+    if ( !m_tracerStats )
+    {
+        m_tracerStats = std::make_shared< GStreamerTracerStats >();
+    }
+    m_tracerStats->reset();
+
+    GstTypes::GstIteratorPtr gstIterator( gst_bin_iterate_recurse( GST_BIN( m_pipeline.get() ) ) );
+    const auto gstIteratorRes = gstIteratorForeach( gstIterator.get(), [ this ](const GValue *value)
+        {
+            m_tracerStats->addElement( GST_ELEMENT( g_value_get_object( value ) ) );
+        }
+    );
+    if ( gstIteratorRes != GST_ITERATOR_DONE )
+    {
+        poco_warning( GstTypes::logger(), "GStreamer::startTracerStats(): Could not iterate all elements, some are left out of the tracer stats" );
+    }
+}
+
+Pothos::ObjectKwargs GStreamer::getTracerStats() const
+{
+    return ( m_tracerStats ) ? m_tracerStats->toObjectKwargs() : Pothos::ObjectKwargs();
+}
+
+void GStreamer::enableElementTiming(const std::vector< std::string > &names)
+{
+    m_timedElements = names;
+    m_elementTimingEnabled = true;
+    if ( m_pipeline )
+    {
+        attachElementTiming();
+    }
+}
+
+void GStreamer::disableElementTiming()
+{
+    m_elementTimingEnabled = false;
+    if ( m_elementTiming )
+    {
+        m_elementTiming->detach();
+    }
+}
+
+void GStreamer::attachElementTiming()
+{
+    std::vector< GstTypes::GstElementPtr > elements;
+    if ( m_timedElements.empty() )
+    {
+        GstTypes::GstIteratorPtr gstIterator( gst_bin_iterate_recurse( GST_BIN( m_pipeline.get() ) ) );
+        const auto gstIteratorRes = gstIteratorForeach( gstIterator.get(), [ &elements ](const GValue *value)
+            {
+                auto element = GST_ELEMENT( g_value_get_object( value ) );
+                // The elements in a bin are timed themselves
+                if ( !GST_IS_BIN( element ) )
+                {
+                    elements.emplace_back( GST_ELEMENT( gst_object_ref( element ) ) );
+                }
+            }
+        );
+        if ( gstIteratorRes != GST_ITERATOR_DONE )
+        {
+            poco_warning( GstTypes::logger(), "GStreamer::attachElementTiming(): Could not iterate all elements, some are not timed" );
+        }
+    }
+    else
+    {
+        for (const auto &name : m_timedElements)
+        {
+            auto element = getPipelineElementByName( name );
+            if ( !element )
+            {
+                throw Pothos::InvalidArgumentException( "GStreamer::attachElementTiming(" + name + ")", "No element named \"" + name + "\" in the pipeline" );
+            }
+            elements.push_back( std::move( element ) );
+        }
+    }
+
+    if ( !m_elementTiming )
+    {
+        m_elementTiming.reset( new GStreamerElementTiming() );
+    }
+    m_elementTiming->attach( elements );
+}
+
+Pothos::ObjectKwargs GStreamer::getElementTiming() const
+{
+    return ( m_elementTiming ) ? m_elementTiming->toObjectKwargs() : Pothos::ObjectKwargs();
+}
+
+void GStreamer::setReplicaKey(const std::string &key)
+{
+    m_replicaKey = key;
+}
+
+const std::string& GStreamer::replicaKey() const
+{
+    return m_replicaKey;
+}
+
+void GStreamer::setLoop(bool loop)
+{
+    m_loop = loop;
+}
+
+uint64_t GStreamer::getLoopCount() const
+{
+    return m_loopCount;
+}
+
+void GStreamer::workerStop(const std::string & reason)
+{
+    // Stop pipeline if there was an error
+    m_pipelineActive = false;
+
+    poco_warning( GstTypes::logger(), "Pipeline has stopped, reason: " + reason + ". This block will do nothing for the remainder of this running topology" );
+}
+
+Pothos::ObjectKwargs GStreamer::gstMessageToFormattedObject(GstMessage *gstMessage)
+{
+    switch ( gstMessage->type )
+    {
+        case GST_MESSAGE_WARNING:
+        {
+            return gstMessageInfoWarnError( gstMessage );
+        }
+
+        case GST_MESSAGE_ERROR:
+        {
+            workerStop( "GStreamer Error" );
+            return gstMessageInfoWarnError( gstMessage );
+        }
+
+        case GST_MESSAGE_INFO:
+        {
+            return gstMessageInfoWarnError( gstMessage );
+        }
+
+        case GST_MESSAGE_STATE_CHANGED:
+        {
+            GstState old_state, new_state, pending;
+
+            gst_message_parse_state_changed( gstMessage, &old_state, &new_state, &pending );
+
+            if ( new_state == GST_STATE_PLAYING && GST_MESSAGE_SRC( gstMessage ) == GST_OBJECT( m_pipeline.get() ) &&
+                 m_playingTime == std::chrono::steady_clock::time_point() )
+            {
+                m_playingTime = std::chrono::steady_clock::now();
+            }
+
+            debugPipelineToDot( this->getName() + " " + gst_element_state_get_name(old_state) + " - " + gst_element_state_get_name(new_state) );
+
+            Pothos::ObjectKwargs objectMsgMap;
+            objectMsgMap[ "old_state" ] = GstTypes::gcharToObject( gst_element_state_get_name( old_state ) );
+            objectMsgMap[ "new_state" ] = GstTypes::gcharToObject( gst_element_state_get_name( new_state ) );
+            objectMsgMap[ "pending"   ] = GstTypes::gcharToObject( gst_element_state_get_name( pending ) );
+
+            return objectMsgMap;
+        }
 
         // Apparently this is a good thing to do??
         // Not sure why though. Taken from example
@@ -443,9 +1387,13 @@ Pothos::ObjectKwargs GStreamer::gstMessageToFormattedObject(GstMessage *gstMessa
 
             Pothos::ObjectKwargs objectMsgMap( clockInfo( clock ) );
 
-            /* Stop and start pipeline to force new clock selection */
-            gst_element_set_state ( reinterpret_cast< GstElement* >( m_pipeline.get() ), GST_STATE_PAUSED);
-            gst_element_set_state ( reinterpret_cast< GstElement* >( m_pipeline.get() ), GST_STATE_PLAYING);
+            // The clock of a clock domain is not selected by the pipeline, choosing a new one would leave the domain
+            if ( !m_clockDomain )
+            {
+                /* Stop and start pipeline to force new clock selection */
+                gst_element_set_state ( reinterpret_cast< GstElement* >( m_pipeline.get() ), GST_STATE_PAUSED);
+                gst_element_set_state ( reinterpret_cast< GstElement* >( m_pipeline.get() ), GST_STATE_PLAYING);
+            }
 
             return objectMsgMap;
         }
@@ -459,7 +1407,11 @@ Pothos::ObjectKwargs GStreamer::gstMessageToFormattedObject(GstMessage *gstMessa
 
         case GST_MESSAGE_EOS:
         {
-            workerStop( "End of stream" );
+            // Looping: the source could not do segment seeks, so start over with a flushing seek
+            if ( !( m_loop && loopSeek( true, GstPipelineQuery::position( GST_ELEMENT( m_pipeline.get() ), GST_FORMAT_TIME ) ) ) )
+            {
+                workerStop( "End of stream" );
+            }
             return Pothos::ObjectKwargs();
         }
 
@@ -550,6 +1502,14 @@ Pothos::ObjectKwargs GStreamer::gstMessageToFormattedObject(GstMessage *gstMessa
             gint64 position;
             gst_message_parse_segment_done( gstMessage, &format, &position );
 
+            // Looping: queue up the next segment, no flush so there is no gap
+            if ( m_loop && GST_MESSAGE_SRC( gstMessage ) == GST_OBJECT( m_pipeline.get() ) )
+            {
+                loopSeek( false, ( format == GST_FORMAT_TIME ) ?
+                    Poco::Optional< int64_t >( position ) :
+                    GstPipelineQuery::position( GST_ELEMENT( m_pipeline.get() ), GST_FORMAT_TIME ) );
+            }
+
             Pothos::ObjectKwargs objectMsgMap;
             objectMsgMap[ "format"   ] = Pothos::Object( GstTypes::gstFormatToObjectKwargs( format ) );
             objectMsgMap[ "position" ] = Pothos::Object( position );
@@ -557,6 +1517,33 @@ Pothos::ObjectKwargs GStreamer::gstMessageToFormattedObject(GstMessage *gstMessa
             return objectMsgMap;
         }
 
+        case GST_MESSAGE_ASYNC_DONE:
+        {
+            // Pipeline has finished its asynchronous state change, disarm watchdog
+            if ( GST_MESSAGE_SRC( gstMessage ) == GST_OBJECT( m_pipeline.get() ) )
+            {
+                m_asyncStatePending = false;
+                m_stateSettled = true;
+
+                // Looping: once prerolled, switch to segment playback so the end is signalled by SEGMENT_DONE instead of EOS
+                if ( m_loop && !m_loopStarted )
+                {
+                    m_loopStarted = true;
+                    if ( !segmentSeek( true ) )
+                    {
+                        poco_information( GstTypes::logger(), "GStreamer: Pipeline does not support segment seeks, looping on EOS instead" );
+                    }
+                }
+            }
+
+            GstClockTime runningTime;
+            gst_message_parse_async_done( gstMessage, &runningTime );
+
+            Pothos::ObjectKwargs objectMsgMap;
+            objectMsgMap[ "running_time" ] = GstTypes::gstClockTimeToObject( runningTime );
+            return objectMsgMap;
+        }
+
         case GST_MESSAGE_LATENCY:
         {
             gst_bin_recalculate_latency( GST_BIN( m_pipeline.get() ) );
@@ -628,17 +1615,20 @@ Pothos::Object GStreamer::gstMessageToObject(GstMessage *gstMessage)
     return Pothos::Object( objectMap );
 }
 
+/**
+ * @brief Wake the block up from waiting for work.
+ *        Can be called from any thread.
+ */
+void GStreamer::notifyWork()
+{
+    m_waker->notify();
+}
+
 void GStreamer::processGstMessagesTimeout(GstClockTime timeout)
 {
     while (true)
     {
-        using GstMessagePtr = std::unique_ptr < GstMessage, GstTypes::detail::Deleter< GstMessage, gst_message_unref > >;
-        GstMessagePtr gstMessage(
-            gst_bus_timed_pop(
-                m_bus.get(),
-                timeout
-            )
-        );
+        GstMessagePtr gstMessage( gst_bus_timed_pop( m_bus.get(), timeout ) );
         // No more message bail
         if ( gstMessage.get() == nullptr )
         {
@@ -647,35 +1637,79 @@ void GStreamer::processGstMessagesTimeout(GstClockTime timeout)
 
         // Only block for time out period on the first loop iteration
         timeout = 0;
-        POTHOS_EXCEPTION_TRY
+        handleGstMessage( gstMessage.get() );
+    }
+}
+
+/**
+ * @brief Handle the messages already on the bus, without waiting for more.
+ *        Stops at EOS or once the pipeline reached the NULL state, anything after is of no interest when tearing down.
+ */
+void GStreamer::drainGstMessages()
+{
+    while (true)
+    {
+        GstMessagePtr gstMessage( gst_bus_pop( m_bus.get() ) );
+        if ( gstMessage.get() == nullptr )
         {
-            auto object = gstMessageToObject( gstMessage.get() );
+            return;
+        }
+
+        handleGstMessage( gstMessage.get() );
 
-            if ( isActive() )
+        switch ( GST_MESSAGE_TYPE( gstMessage.get() ) )
+        {
+            case GST_MESSAGE_EOS:
+                return;
+            case GST_MESSAGE_STATE_CHANGED:
             {
-                // Dedicated signals we send
-                switch ( GST_MESSAGE_TYPE( gstMessage.get() ) )
+                if ( GST_MESSAGE_SRC( gstMessage.get() ) == GST_OBJECT( m_pipeline.get() ) )
                 {
-                    case GST_MESSAGE_EOS:
-                        this->emitSignal( SIGNAL_EOS_NAME, object );
-                        break;
-                    case GST_MESSAGE_TAG:
-                        this->emitSignal( SIGNAL_TAG, object );
-                        break;
-                    // To silence the compilers
-                    default:
-                        break;
+                    GstState newState;
+                    gst_message_parse_state_changed( gstMessage.get(), nullptr, &newState, nullptr );
+                    if ( newState == GST_STATE_NULL )
+                    {
+                        return;
+                    }
                 }
-
-                // Push the GStreamer message out as a Pothos signal
-                this->emitSignal(SIGNAL_BUS_NAME, object);
+                break;
             }
+            default:
+                break;
         }
-        POTHOS_EXCEPTION_CATCH (const Pothos::Exception & e)
+    }
+}
+
+void GStreamer::handleGstMessage(GstMessage *gstMessage)
+{
+    POTHOS_EXCEPTION_TRY
+    {
+        auto object = gstMessageToObject( gstMessage );
+
+        if ( isActive() )
         {
-            poco_error(GstTypes::logger(), "GStreamer::processGStreamerMessagesTimeout error: " + e.displayText());
+            // Dedicated signals we send
+            switch ( GST_MESSAGE_TYPE( gstMessage ) )
+            {
+                case GST_MESSAGE_EOS:
+                    this->emitSignal( SIGNAL_EOS_NAME, object );
+                    break;
+                case GST_MESSAGE_TAG:
+                    this->emitSignal( SIGNAL_TAG, object );
+                    break;
+                // To silence the compilers
+                default:
+                    break;
+            }
+
+            // Push the GStreamer message out as a Pothos signal
+            this->emitSignal(SIGNAL_BUS_NAME, object);
         }
     }
+    POTHOS_EXCEPTION_CATCH (const Pothos::Exception & e)
+    {
+        poco_error(GstTypes::logger(), "GStreamer::handleGstMessage error: " + e.displayText());
+    }
 }
 
 void GStreamer::setState(const std::string &state)
@@ -690,10 +1724,12 @@ void GStreamer::setState(const std::string &state)
     {
         const auto value = GstTypes::findValueByKey( std::begin(stateOptions), std::end(stateOptions), state );
 
-        // Can only change the state if the pipeline is running
-        if ( m_pipelineActive )
+        // Can only change the state if the pipeline is running.
+        // While prerolling the requested state is changed to once prerolled.
+        // A state change that timed out has torn the pipeline down, or one that failed has thrown, the state is left as it was
+        if ( m_pipelineActive && !m_prerolling && !this->gstChangeState( value ) )
         {
-            this->gstChangeState( value );
+            return;
         }
         m_gstState = value;
     }
@@ -713,30 +1749,19 @@ GstPipeline* GStreamer::getPipeline() const
     return m_pipeline.get();
 }
 
-static inline Pothos::Object gstClockTimeToObject(const GstClockTime gstClockTime)
-{
-    return (gstClockTime == GST_CLOCK_TIME_NONE) ? Pothos::Object() : Pothos::Object(gstClockTime);
-}
-
 Pothos::Object GStreamer::getPipelineLatency() const
 {
-    std::unique_ptr < GstQuery, GstTypes::detail::Deleter< GstQuery, gst_query_unref > > query( gst_query_new_latency() );
-    const auto res = gst_element_query( GST_ELEMENT( m_pipeline.get() ), query.get() );
-    if (res == FALSE)
+    if ( m_pipelineSampler )
     {
-        return Pothos::Object();
+        return m_pipelineSampler->latency();
     }
 
-    gboolean live;
-    GstClockTime min_latency;
-    GstClockTime max_latency;
-    gst_query_parse_latency(query.get(), &live, &min_latency, &max_latency);
+    if ( !m_pipeline )
+    {
+        return Pothos::Object();
+    }
 
-    Pothos::ObjectKwargs args;
-    args["live"       ] = Pothos::Object( static_cast< bool >( live ) );
-    args["min_latency"] = gstClockTimeToObject( min_latency );
-    args["max_latency"] = gstClockTimeToObject( max_latency );
-    return Pothos::Object::make( args );
+    return GstPipelineQuery::latency( GST_ELEMENT( m_pipeline.get() ) );
 }
 
 static constexpr std::array< std::pair< const char * const, GstFormat >, 5 > formatOptions
@@ -754,10 +1779,19 @@ int64_t GStreamer::getPipelinePosition(const std::string &format) const
     {
         const auto value = GstTypes::findValueByKey( std::begin(formatOptions), std::end(formatOptions), format );
 
-        gint64 position;
-        if ( gst_element_query_position(GST_ELEMENT( m_pipeline.get() ), value, &position) == TRUE )
+        Poco::Optional< int64_t > position;
+        if ( m_pipelineSampler )
+        {
+            position = m_pipelineSampler->position( value );
+        }
+        else if ( m_pipeline )
         {
-            return position;
+            position = GstPipelineQuery::position( GST_ELEMENT( m_pipeline.get() ), value );
+        }
+
+        if ( position.isSpecified() )
+        {
+            return position.value();
         }
         throw Pothos::PropertyNotSupportedException("GStreamer::getPipelinePosition("+format+")", " not supported");
     }
@@ -773,10 +1807,19 @@ int64_t GStreamer::getPipelineDuration(const std::string &format) const
     {
         const auto value = GstTypes::findValueByKey( std::begin(formatOptions), std::end(formatOptions), format );
 
-        gint64 duration;
-        if ( gst_element_query_duration(GST_ELEMENT( m_pipeline.get() ), value, &duration) == TRUE )
+        Poco::Optional< int64_t > duration;
+        if ( m_pipelineSampler )
+        {
+            duration = m_pipelineSampler->duration( value );
+        }
+        else if ( m_pipeline )
+        {
+            duration = GstPipelineQuery::duration( GST_ELEMENT( m_pipeline.get() ), value );
+        }
+
+        if ( duration.isSpecified() )
         {
-            return duration;
+            return duration.value();
         }
 
         throw Pothos::PropertyNotSupportedException("GStreamer::getPipelineDuration("+format+")", " not supported");
@@ -787,6 +1830,234 @@ int64_t GStreamer::getPipelineDuration(const std::string &format) const
     }
 }
 
+static constexpr std::array< std::pair< const char * const, GstSeekFlags >, 10 > seekFlagOptions
+{ {
+    { "FLUSH"               , GST_SEEK_FLAG_FLUSH               },
+    { "ACCURATE"            , GST_SEEK_FLAG_ACCURATE            },
+    { "KEY_UNIT"            , GST_SEEK_FLAG_KEY_UNIT            },
+    { "SEGMENT"             , GST_SEEK_FLAG_SEGMENT             },
+    { "SNAP_BEFORE"         , GST_SEEK_FLAG_SNAP_BEFORE         },
+    { "SNAP_AFTER"          , GST_SEEK_FLAG_SNAP_AFTER          },
+    { "SNAP_NEAREST"        , GST_SEEK_FLAG_SNAP_NEAREST        },
+    { "TRICKMODE"           , GST_SEEK_FLAG_TRICKMODE           },
+    { "TRICKMODE_KEY_UNITS" , GST_SEEK_FLAG_TRICKMODE_KEY_UNITS },
+    { "TRICKMODE_NO_AUDIO"  , GST_SEEK_FLAG_TRICKMODE_NO_AUDIO  }
+} };
+
+void GStreamer::seek(const std::string &format, int64_t position, double rate, const std::vector< std::string > &flags)
+{
+    const std::string funcName( "GStreamer::seek(" + format + ", " + std::to_string( position ) + ", " + std::to_string( rate ) + ")" );
+
+    if ( !m_pipeline )
+    {
+        throw Pothos::RuntimeException( funcName, "Pipeline has not been created" );
+    }
+    if ( rate == 0.0 )
+    {
+        throw Pothos::InvalidArgumentException( funcName, "Rate can not be 0, use setState(\"PAUSE\") to pause" );
+    }
+
+    GstFormat gstFormat;
+    int seekFlags = GST_SEEK_FLAG_NONE;
+    try
+    {
+        gstFormat = GstTypes::findValueByKey( std::begin(formatOptions), std::end(formatOptions), format );
+        for (const auto &flag : flags)
+        {
+            seekFlags |= GstTypes::findValueByKey( std::begin(seekFlagOptions), std::end(seekFlagOptions), flag );
+        }
+    }
+    catch (const Pothos::NotFoundException &e)
+    {
+        throw Pothos::InvalidArgumentException( funcName, e.message() );
+    }
+
+    // Negative position, change the rate from where the stream is now.
+    // Query the pipeline, the sampler's position can be up to a probe period old
+    if ( position < 0 )
+    {
+        const auto current = GstPipelineQuery::position( GST_ELEMENT( m_pipeline.get() ), gstFormat );
+        if ( !current.isSpecified() )
+        {
+            throw Pothos::RuntimeException( funcName, "Could not query the current position" );
+        }
+        position = current.value();
+    }
+
+    // Looping continues on SEGMENT_DONE, a seek without SEGMENT would end the loop in EOS
+    if ( m_loop )
+    {
+        seekFlags |= GST_SEEK_FLAG_SEGMENT;
+    }
+
+    // Going backwards, play from the position back to the start
+    const auto seeked = ( rate > 0.0 ) ?
+        gst_element_seek( GST_ELEMENT( m_pipeline.get() ), rate, gstFormat, static_cast< GstSeekFlags >( seekFlags ),
+                          GST_SEEK_TYPE_SET, position, GST_SEEK_TYPE_NONE, GST_CLOCK_TIME_NONE ) :
+        gst_element_seek( GST_ELEMENT( m_pipeline.get() ), rate, gstFormat, static_cast< GstSeekFlags >( seekFlags ),
+                          GST_SEEK_TYPE_SET, 0, GST_SEEK_TYPE_SET, position );
+    if ( seeked == FALSE )
+    {
+        throw Pothos::RuntimeException( funcName, "Pipeline could not seek" );
+    }
+
+    // Following loops keep the rate and flags, loop seeks are in time and add their own FLUSH and SEGMENT
+    m_loopRate = rate;
+    m_loopSeekFlags = static_cast< GstSeekFlags >( seekFlags & ~( GST_SEEK_FLAG_FLUSH | GST_SEEK_FLAG_SEGMENT ) );
+    // Already in segment playback, the seek after preroll would go back to the start
+    m_loopStarted = m_loopStarted || m_loop;
+}
+
+int64_t GStreamer::getTeardownDuration() const
+{
+    return m_teardownDurationNs;
+}
+
+void GStreamer::replaceBin(const std::string &name, const std::string &description)
+{
+    const std::string funcName( "GStreamer::replaceBin(" + name + ")" );
+
+    if ( !m_pipelineActive )
+    {
+        throw Pothos::RuntimeException( funcName, "Pipeline is not running" );
+    }
+
+    auto oldElement = getPipelineElementByName( name );
+    if ( !oldElement )
+    {
+        throw Pothos::InvalidArgumentException( funcName, "No element named \"" + name + "\" in the pipeline" );
+    }
+
+    // The ports must stay bound to their elements
+    for (const auto &subWorker : m_gstreamerSubWorkers)
+    {
+        const GstTypes::GstElementPtr child(
+            GST_IS_BIN( oldElement.get() ) ? gst_bin_get_by_name( GST_BIN( oldElement.get() ), subWorker->name().c_str() ) : nullptr
+        );
+        if ( subWorker->name() == name || child )
+        {
+            throw Pothos::InvalidArgumentException( funcName, "Can not replace port \"" + subWorker->name() + "\"" );
+        }
+    }
+
+    GstTypes::GErrorPtr errorPtr;
+    GstElement *newElement = gst_parse_bin_from_description( description.c_str(), TRUE, GstTypes::uniqueOutArg( errorPtr ) );
+    if ( newElement == nullptr )
+    {
+        throw Pothos::InvalidArgumentException( funcName, "Failed to parse ( " + description + " ). Error: " + GstTypes::gerrorToString( errorPtr.get() ) );
+    }
+    if ( errorPtr )
+    {
+        poco_warning( GstTypes::logger(), funcName + ": Created replacement, but had warning: " + GstTypes::gerrorToString( errorPtr.get() ) );
+    }
+
+    GstBinSwap::replace( m_pipeline.get(), oldElement.get(), newElement );
+}
+
+/**
+ * @brief Find an element to set properties on, remembered until the pipeline is destroyed.
+ */
+GstElement* GStreamer::getPropertyElement(const std::string &name)
+{
+    const auto element_it = m_propertyElements.find( name );
+    if ( element_it != m_propertyElements.cend() )
+    {
+        // An element replaced by replaceBin is no longer in a bin, it is unparented from a streaming thread so take the object lock
+        std::unique_ptr< GstObject, GstTypes::GstObjectUnrefFunc > parent( gst_object_get_parent( GST_OBJECT( element_it->second.get() ) ) );
+        if ( parent )
+        {
+            return element_it->second.get();
+        }
+    }
+
+    auto element = getPipelineElementByName( name );
+    if ( !element )
+    {
+        throw Pothos::InvalidArgumentException( "GStreamer::getPropertyElement(" + name + ")", "No element named \"" + name + "\" in the pipeline" );
+    }
+    auto gstElement = element.get();
+    m_propertyElements[ name ] = std::move( element );
+    return gstElement;
+}
+
+/**
+ * @brief Find the GParamSpec of a property. GParamSpecs belong to the element class, so are kept for every element of the same type.
+ */
+GParamSpec* GStreamer::findParamSpec(GstElement *element, const std::string &property)
+{
+    const auto key = std::make_pair( G_OBJECT_TYPE( element ), property );
+    const auto paramSpec_it = m_paramSpecs.find( key );
+    if ( paramSpec_it != m_paramSpecs.cend() )
+    {
+        return paramSpec_it->second;
+    }
+
+    auto paramSpec = g_object_class_find_property( G_OBJECT_GET_CLASS( element ), property.c_str() );
+    if ( paramSpec != nullptr )
+    {
+        m_paramSpecs.emplace( key, paramSpec );
+    }
+    return paramSpec;
+}
+
+void GStreamer::setElementProperty(const std::string &name, const std::string &property, const Pothos::Object &value)
+{
+    Pothos::ObjectKwargs properties;
+    properties[ property ] = value;
+    setElementProperties( name, properties );
+}
+
+void GStreamer::setElementProperties(const std::string &name, const Pothos::ObjectKwargs &properties)
+{
+    const std::string funcName( "GStreamer::setElementProperties(" + name + ")" );
+
+    if ( !m_pipeline )
+    {
+        throw Pothos::RuntimeException( funcName, "Pipeline has not been created" );
+    }
+
+    auto element = getPropertyElement( name );
+
+    // Convert every value first, so an invalid one changes nothing
+    std::vector< std::pair< GParamSpec*, std::unique_ptr< GstTypes::GVal > > > values;
+    values.reserve( properties.size() );
+    for (const auto &property : properties)
+    {
+        auto paramSpec = findParamSpec( element, property.first );
+        if ( paramSpec == nullptr )
+        {
+            throw Pothos::InvalidArgumentException( funcName, "No property \"" + property.first + "\"" );
+        }
+        if ( ( paramSpec->flags & G_PARAM_WRITABLE ) == 0 || ( paramSpec->flags & G_PARAM_CONSTRUCT_ONLY ) != 0 )
+        {
+            throw Pothos::InvalidArgumentException( funcName, "Property \"" + property.first + "\" can not be changed" );
+        }
+
+        std::unique_ptr< GstTypes::GVal > value( new GstTypes::GVal( G_PARAM_SPEC_VALUE_TYPE( paramSpec ) ) );
+        try
+        {
+            GstTypes::objectToGValue( property.second, (*value)() );
+        }
+        catch (const Pothos::Exception &e)
+        {
+            throw Pothos::InvalidArgumentException( funcName, "Property \"" + property.first + "\": " + e.message() );
+        }
+        if ( g_param_value_validate( paramSpec, (*value)() ) == TRUE )
+        {
+            throw Pothos::InvalidArgumentException( funcName, "Property \"" + property.first + "\" value " + property.second.toString() + " is out of range" );
+        }
+        values.emplace_back( paramSpec, std::move( value ) );
+    }
+
+    // Notifications are held back until every property is set
+    g_object_freeze_notify( G_OBJECT( element ) );
+    for (auto &value : values)
+    {
+        g_object_set_property( G_OBJECT( element ), value.first->name, (*value.second)() );
+    }
+    g_object_thaw_notify( G_OBJECT( element ) );
+}
+
 std::string GStreamer::getPipelineGraph()
 {
     if (m_pipeline == nullptr)
@@ -807,19 +2078,125 @@ void GStreamer::savePipelineGraph(const std::string &fileName)
     dotFile.close();
 }
 
-void GStreamer::gstChangeState( GstState state )
+void GStreamer::setStateChangeTimeout(long timeoutMs)
+{
+    if ( timeoutMs < 0 )
+    {
+        throw Pothos::InvalidArgumentException("GStreamer::setStateChangeTimeout("+std::to_string( timeoutMs )+")", "Timeout can not be negative");
+    }
+    m_stateChangeTimeoutMs = timeoutMs;
+}
+
+namespace
+{
+    struct AsyncSetState
+    {
+        GstState state;
+        std::promise< GstStateChangeReturn > result;
+
+        static void call(GstElement *element, gpointer userData)
+        {
+            auto self = *static_cast< std::shared_ptr< AsyncSetState >* >( userData );
+            self->result.set_value( gst_element_set_state( element, self->state ) );
+        }
+
+        static void destroy(gpointer userData)
+        {
+            // NOLINTNEXTLINE(cppcoreguidelines-owning-memory)
+            delete static_cast< std::shared_ptr< AsyncSetState >* >( userData );
+        }
+    };  // struct AsyncSetState
+}  // namespace
+
+/**
+ * @brief Change state from a GStreamer thread, as gst_element_set_state can block.
+ * @return The state change return or nothing if gst_element_set_state did not return within the timeout
+ */
+Poco::Optional< GstStateChangeReturn > GStreamer::gstSetStateTimeout( GstState state )
+{
+    auto asyncSetState = std::make_shared< AsyncSetState >();
+    asyncSetState->state = state;
+    auto result = asyncSetState->result.get_future();
+
+    gst_element_call_async(
+        GST_ELEMENT( m_pipeline.get() ),
+        &AsyncSetState::call,
+        new std::shared_ptr< AsyncSetState >( asyncSetState ),
+        &AsyncSetState::destroy
+    );
+
+    if ( result.wait_for( std::chrono::milliseconds( m_stateChangeTimeoutMs ) ) != std::future_status::ready )
+    {
+        return { };
+    }
+    return result.get();
+}
+
+void GStreamer::stateChangeTimeout( GstState state, const std::string &reason )
+{
+    const std::string message( "State change to " + std::string( gst_element_state_get_name( state ) ) + " timed out: " + reason );
+    poco_error( GstTypes::logger(), "GStreamer::stateChangeTimeout() " + message + ". Pipeline: " + getPipelineString() );
+
+    Pothos::ObjectKwargs body;
+    body[ "state"      ] = GstTypes::gcharToObject( gst_element_state_get_name( state ) );
+    body[ "timeout_ms" ] = Pothos::Object( m_stateChangeTimeoutMs );
+    body[ "message"    ] = Pothos::Object( message );
+
+    Pothos::ObjectKwargs objectMap;
+    objectMap[ "type_name" ] = Pothos::Object( std::string( "state-change-timeout" ) );
+    objectMap[ "src_name"  ] = Pothos::Object( this->getName() );
+    objectMap[ "body"      ] = Pothos::Object::make( body );
+
+    // Sent from work() as we may not be active yet
+    m_pendingBusSignals.push_back( Pothos::Object( objectMap ) );
+
+    workerStop( message );
+    m_asyncStatePending = false;
+
+    // Tear down, any GStreamer thread still stuck in the state change holds its own reference to the pipeline
+    for (auto &subWorker : m_gstreamerSubWorkers)
+    {
+        subWorker->deactivate();
+    }
+    destroyPipeline();
+}
+
+/**
+ * @brief Change the pipeline state
+ * @return false if the state change timed out and the pipeline was torn down
+ */
+bool GStreamer::gstChangeState( GstState state )
 {
     const std::string funcName( "GStreamer::gstChangeState()" );
     if ( !m_pipeline )
     {
         poco_warning( GstTypes::logger(), funcName + " Will do nothing as pipeline is NULL" );
-        return;
+        return true;
     }
 
-    // TODO: Some times change state hangs(blocks).
-    //   This function is not ment to block from the GStreamer docs.
-    //   Should we safe guard our selfs from this or just let it crash Pothos ?????
-    const auto stateChangeReturn = gst_element_set_state( GST_ELEMENT( m_pipeline.get() ), state );
+    // Some times change state hangs(blocks), even though it is not ment to from the GStreamer docs.
+    // With a timeout set we safe guard our selfs from this by changing state on a GStreamer thread.
+    GstStateChangeReturn stateChangeReturn;
+    if ( m_stateChangeTimeoutMs > 0 )
+    {
+        const auto result = gstSetStateTimeout( state );
+        if ( !result.isSpecified() )
+        {
+            // Going to NULL is already tearing down, just let go of the pipeline
+            if ( state == GST_STATE_NULL )
+            {
+                poco_error( GstTypes::logger(), funcName + " Timed out changing state to NULL. Pipeline: " + getPipelineString() );
+                return false;
+            }
+            stateChangeTimeout( state, "gst_element_set_state did not return" );
+            return false;
+        }
+        stateChangeReturn = result.value();
+    }
+    else
+    {
+        stateChangeReturn = gst_element_set_state( GST_ELEMENT( m_pipeline.get() ), state );
+    }
 
     auto throwError = [funcName](const std::string& errorStr)
     {
@@ -832,8 +2209,19 @@ void GStreamer::gstChangeState( GstState state )
             throwError("State change failure");
             break;
         case GST_STATE_CHANGE_SUCCESS:
+            m_asyncStatePending = false;
+            m_stateSettled = true;
+            return true;
         case GST_STATE_CHANGE_ASYNC:
-            return;
+            m_stateSettled = false;
+            // Arm watchdog, disarmed by GST_MESSAGE_ASYNC_DONE
+            if ( m_stateChangeTimeoutMs > 0 )
+            {
+                m_asyncStatePending = true;
+                m_asyncTargetState = state;
+                m_asyncStateDeadline = std::chrono::steady_clock::now() + std::chrono::milliseconds( m_stateChangeTimeoutMs );
+            }
+            return true;
         case GST_STATE_CHANGE_NO_PREROLL:
             poco_warning(
                 GstTypes::logger(),
@@ -844,41 +2232,151 @@ void GStreamer::gstChangeState( GstState state )
             poco_information(
                 GstTypes::logger(),
                 funcName + " Current state: " + gst_element_state_get_name( state ) + " . Pipeline: " + getPipelineString() );
-            return;
+            m_asyncStatePending = false;
+            m_stateSettled = true;
+            m_livePipeline = true;
+            return true;
     }
     throwError(gst_element_state_change_return_get_name( stateChangeReturn ));
+    return false;
+}
+
+void GStreamer::setProbeRate(double rateHz)
+{
+    if ( rateHz < 0.0 )
+    {
+        throw Pothos::InvalidArgumentException("GStreamer::setProbeRate("+std::to_string( rateHz )+")", "Rate can not be negative");
+    }
+    m_probeRateHz = rateHz;
+}
+
+void GStreamer::setActivationMode(const std::string &mode)
+{
+    static constexpr std::array< std::pair< const char * const, bool >, 2 > modeOptions =
+    { {
+        { "DIRECT"  , false },
+        { "PREROLL" , true  }
+    } };
+
+    try
+    {
+        m_prerollActivation = GstTypes::findValueByKey( std::begin(modeOptions), std::end(modeOptions), mode );
+    }
+    catch (const Pothos::NotFoundException &e)
+    {
+        throw Pothos::InvalidArgumentException("GStreamer::setActivationMode("+mode+")", e.message());
+    }
+}
+
+/**
+ * @brief When prerolling, change to the requested state once the pipeline and all sub workers are ready.
+ */
+void GStreamer::checkPrerolled()
+{
+    if ( !m_prerolling || !m_stateSettled )
+    {
+        return;
+    }
+
+    // Live pipelines do not preroll, so there is nothing to wait for
+    if ( !m_livePipeline )
+    {
+        for (auto &subWorker : m_gstreamerSubWorkers)
+        {
+            if ( !subWorker->prerolled() )
+            {
+                return;
+            }
+        }
+    }
+
+    m_prerolling = false;
+    if ( GstTypes::debug_extra )
+    {
+        poco_information( GstTypes::logger(), "GStreamer::checkPrerolled() prerolled, changing state to " + std::string( gst_element_state_get_name( m_gstState ) ) );
+    }
+    gstChangeState( m_gstState );
 }
 
 void GStreamer::activate()
 {
-    // Recreate pipeline if it got destroyed last time round
+    // Create the pipeline, if it was not needed to find ports or got destroyed last time round
     if ( m_pipeline == nullptr )
     {
+        poco_information( GstTypes::logger(), "About to create pipeline: " + m_pipeline_string );
         createPipeline();
     }
 
+    if ( m_offlineMode )
+    {
+        applyOfflineMode();
+    }
+    else if ( !m_clockDomainName.empty() )
+    {
+        m_clockDomain = GstStatic::ClockDomain::acquire( m_clockDomainName );
+        m_clockDomain->apply( m_pipeline.get() );
+    }
+
+    // Set before going to PAUSED, when the streaming threads start
+    if ( !std::atomic_load( &m_threadPolicy ) && GStreamerThreadPolicy::enabled( m_streamingCpus, m_streamingNice ) )
+    {
+        std::atomic_store( &m_threadPolicy, std::make_shared< GStreamerThreadPolicy >( m_streamingCpus, m_streamingNice ) );
+    }
+
+    startTracerStats();
+
+    if ( m_elementTimingEnabled )
+    {
+        attachElementTiming();
+    }
+
     for (auto &subWorker : m_gstreamerSubWorkers)
     {
+        subWorker->resetPortStats();
         subWorker->activate();
     }
+    m_lastStatsTime = std::chrono::steady_clock::now();
+
+    m_stateSettled = false;
+    m_livePipeline = false;
+    m_loopStarted = false;
+    m_loopCount = 0;
+    m_loopRate = 1.0;
+    m_loopSeekFlags = GST_SEEK_FLAG_NONE;
+    m_loopedNs = 0;
+    m_playingTime = std::chrono::steady_clock::time_point();
+
+    // Preroll in paused first when going to playing
+    m_prerolling = m_prerollActivation && ( m_gstState == GST_STATE_PLAYING );
 
     try
     {
-        gstChangeState( m_gstState );
+        if ( !gstChangeState( m_prerolling ? GST_STATE_PAUSED : m_gstState ) )
+        {
+            // Timed out and torn down, nothing more to do for this running topology
+            return;
+        }
     }
     catch (...)
     {
         // Process any GStreamer messages left on the bus so we can print errors.
-        processGstMessagesTimeout( 100 * GST_MSECOND );
+        drainGstMessages();
 
         throw;
     }
 
+    if ( m_probeRateHz > 0.0 )
+    {
+        m_pipelineSampler.reset( new GStreamerPipelineSampler( m_pipeline.get(), m_probeRateHz ) );
+    }
+
     m_pipelineActive = true;
 }
 
 void GStreamer::deactivate()
 {
+    m_prerolling = false;
+
     for (auto &subWorker : m_gstreamerSubWorkers)
     {
         subWorker->deactivate();
@@ -892,27 +2390,67 @@ void GStreamer::propagateLabels(const Pothos::InputPort * /*input*/)
 {
 }
 
+/**
+ * @brief Send the signals we could not send when they happened
+ */
+void GStreamer::emitPendingBusSignals()
+{
+    for (const auto &object : m_pendingBusSignals)
+    {
+        this->emitSignal( SIGNAL_BUS_NAME, object );
+    }
+    m_pendingBusSignals.clear();
+}
+
 void GStreamer::work()
 {
+    emitPendingBusSignals();
+
     if ( m_pipelineActive == false )
     {
         return;
     }
 
-    // Calculate time slices if we have more then one sub-worker
-    auto nodeTimeoutNs = this->workInfo().maxTimeoutNs;
-    nodeTimeoutNs = (m_blockingNodes != 0) ? (nodeTimeoutNs / m_blockingNodes) : nodeTimeoutNs;
-
-    // Calculate message time out
-    const auto gstMessageTimeout = (this->m_blockingNodes == 0) ? (nodeTimeoutNs * GST_NSECOND) : 0;
+    // Wait once for anything to do, woken by the bus and the appsink and appsrc callbacks,
+    // unless a sub worker can get on with it straight away
+    if ( readySubWorkers().empty() )
+    {
+        m_waker->wait( std::chrono::nanoseconds( this->workInfo().maxTimeoutNs ) );
+    }
 
     // Handle GStreamer messages and forwarding into Pothos via signals
-    processGstMessagesTimeout( gstMessageTimeout );
+    processGstMessagesTimeout( 0 );
 
-    // Send data to and from GStreamer into Pothos
-    for (auto &subWorker : m_gstreamerSubWorkers)
+    // Only checked once the bus is drained, an ASYNC_DONE already on it disarms the watchdog
+    if ( m_asyncStatePending && ( std::chrono::steady_clock::now() > m_asyncStateDeadline ) )
+    {
+        stateChangeTimeout( m_asyncTargetState, "ASYNC_DONE not received" );
+        emitPendingBusSignals();
+        return;
+    }
+
+    // Bind declared sub workers to elements that have been added since
+    if ( m_elementAdded.exchange( false ) )
     {
-        subWorker->work( nodeTimeoutNs );
+        bindDeclaredSubWorkers();
+    }
+
+    // Send data to and from GStreamer into Pothos, only for the sub workers that have any, fullest first
+    for (auto subWorker : readySubWorkers())
+    {
+        subWorker->work();
+    }
+
+    checkPrerolled();
+
+    if ( m_statsInterval.count() > 0 && ( std::chrono::steady_clock::now() - m_lastStatsTime ) >= m_statsInterval )
+    {
+        m_lastStatsTime = std::chrono::steady_clock::now();
+        this->emitSignal( SIGNAL_PORT_STATS, getPortStats() );
+        if ( m_tracerStats )
+        {
+            this->emitSignal( SIGNAL_TRACER_STATS, getTracerStats() );
+        }
     }
 
     this->yield();
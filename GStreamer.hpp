@@ -6,16 +6,35 @@
 #include "GStreamerTypes.hpp"
 #include <Pothos/Framework.hpp>
 #include <gst/gst.h>
+#include <atomic>
+#include <chrono>
+#include <map>
 #include <string>
 #include <memory>  /* std::unique_ptr */
 #include <type_traits>
+#include <vector>
 
 extern const char SIGNAL_BUS_NAME[];
 extern const char SIGNAL_TAG[];
 extern const char SIGNAL_EOS_NAME[];
+extern const char SIGNAL_PORT_STATS[];
 
 // Forward declare
 class GStreamerSubWorker;
+class GStreamerPipelineSampler;
+class GStreamerReplicas;
+class GStreamerElementTiming;
+class GStreamerThreadPolicy;
+class GStreamerTracerStats;
+namespace GstStatic
+{
+    class Waker;
+    class ClockDomain;
+}  // namespace GstStatic
+namespace GstPipelineDescription
+{
+    struct Description;
+}  // namespace GstPipelineDescription
 
 class GStreamer : public Pothos::Block
 {
@@ -24,21 +43,107 @@ private:
     std::unique_ptr< GstPipeline, GstTypes::GstObjectUnrefFunc > m_pipeline;
     std::unique_ptr< GstBus, GstTypes::GstObjectUnrefFunc > m_bus;
     std::vector< std::unique_ptr< GStreamerSubWorker > > m_gstreamerSubWorkers;
-    int m_blockingNodes;
     bool m_pipelineActive;
     GstState m_gstState;
+    std::atomic_bool m_elementAdded;
+    long m_stateChangeTimeoutMs;
+    bool m_asyncStatePending;
+    GstState m_asyncTargetState;
+    std::chrono::steady_clock::time_point m_asyncStateDeadline;
+    Pothos::ObjectVector m_pendingBusSignals;
+    bool m_prerollActivation;
+    bool m_prerolling;
+    bool m_stateSettled;
+    bool m_livePipeline;
+    double m_probeRateHz;
+    std::unique_ptr< GStreamerPipelineSampler > m_pipelineSampler;
+    std::shared_ptr< GstStatic::Waker > m_waker;
+    std::atomic< int64_t > m_teardownDurationNs;
+    std::map< std::string, GstTypes::GstElementPtr > m_propertyElements;
+    std::map< std::pair< GType, std::string >, GParamSpec* > m_paramSpecs;
+    bool m_loop;
+    bool m_loopStarted;
+    std::atomic< uint64_t > m_loopCount;
+    // Rate and flags of the last seek(), reused by the loop seeks
+    double m_loopRate;
+    GstSeekFlags m_loopSeekFlags;
+    std::atomic_bool m_offlineMode;
+    // When the pipeline first got to PLAYING since activation, the epoch until then
+    std::chrono::steady_clock::time_point m_playingTime;
+    // Stream time of the loops before the current one
+    int64_t m_loopedNs;
+    size_t m_replicas;
+    std::string m_replicaKey;
+    std::string m_clockDomainName;
+    std::shared_ptr< GstStatic::ClockDomain > m_clockDomain;
+    std::vector< int > m_streamingCpus;
+    int m_streamingNice;
+    // Read by the bus sync handler from streaming threads, only accessed with std::atomic_load and std::atomic_store
+    std::shared_ptr< GStreamerThreadPolicy > m_threadPolicy;
+    std::chrono::nanoseconds m_statsInterval;
+    std::chrono::steady_clock::time_point m_lastStatsTime;
+    bool m_measureLatency;
+    bool m_minimalMetadata;
+    std::vector< std::string > m_tracers;
+    std::shared_ptr< GStreamerTracerStats > m_tracerStats;
+    bool m_elementTimingEnabled;
+    std::vector< std::string > m_timedElements;
+    std::unique_ptr< GStreamerElementTiming > m_elementTiming;
+    std::vector< GStreamerSubWorker* > m_readySubWorkers;
+    std::vector< double > m_readyOccupancy;
 
-    void gstChangeState( GstState state );
+    using GstMessagePtr = std::unique_ptr < GstMessage, GstTypes::detail::Deleter< GstMessage, gst_message_unref > >;
+
+    bool gstChangeState( GstState state );
+    Poco::Optional< GstStateChangeReturn > gstSetStateTimeout( GstState state );
+    void stateChangeTimeout( GstState state, const std::string &reason );
     void workerStop(const std::string &reason);
+    bool segmentSeek(bool flush);
+    bool loopSeek(bool flush, Poco::Optional< int64_t > loopEndNs);
     Pothos::ObjectKwargs gstMessageToFormattedObject(GstMessage *gstMessage);
     Pothos::Object gstMessageToObject(GstMessage *gstMessage);
     void processGstMessagesTimeout(GstClockTime timeout);
+    void drainGstMessages();
+    void emitPendingBusSignals();
+    void handleGstMessage(GstMessage *gstMessage);
     void setState(const std::string &state);
+    void declareAppSrcs(const std::vector< std::string > &names);
+    void declareAppSinks(const std::vector< std::string > &names);
+    void setStateChangeTimeout(long timeoutMs);
+    void setActivationMode(const std::string &mode);
+    void setProbeRate(double rateHz);
+    void setLoop(bool loop);
+    void setOfflineMode(bool enable);
+    void setReplicas(int replicas);
+    void setReplicaKey(const std::string &key);
+    void setClockDomain(const std::string &name);
+    void setStreamingCpus(const std::vector< int > &cpus);
+    void setStreamingNice(int nice);
+    void setStatsInterval(double seconds);
+    void setMeasureLatency(bool enable);
+    void setMetadataMode(const std::string &mode);
+    void setTracers(const std::vector< std::string > &tracers);
+    void startTracerStats();
+    void enableElementTiming(const std::vector< std::string > &names);
+    void disableElementTiming();
+    void attachElementTiming();
+    void checkPrerolled();
     void findSourcesAndSinks(GstBin *bin);
+    void createSubWorkers(const GstPipelineDescription::Description &description);
+    const std::vector< GStreamerSubWorker* >& readySubWorkers();
+    static GstBusSyncReply busSyncHandler(GstBus *bus, GstMessage *message, gpointer userData);
+    bool hasSubWorker(const std::string &name) const;
+    void bindDeclaredSubWorkers();
+    static void deepElementAdded(GstBin *bin, GstBin *subBin, GstElement *element, gpointer userData);
+    static void disableSinkSync(GstElement *element);
+    void applyOfflineMode();
+    GstElement* createReplicaPipeline();
     void createPipeline();
     void destroyPipeline();
     Pothos::ObjectKwargs gstMessageInfoWarnError( GstMessage *message );
     void debugPipelineToDot(const std::string &fileName);
+    GstElement* getPropertyElement(const std::string &name);
+    GParamSpec* findParamSpec(GstElement *element, const std::string &property);
 
 public:
     GStreamer(const GStreamer&) = delete;
@@ -51,11 +156,31 @@ public:
 
     GstTypes::GstElementPtr getPipelineElementByName(const std::string &name) const;
 
+    void notifyWork();
+
     std::string getPipelineString() const;
     GstPipeline* getPipeline() const;
     Pothos::Object getPipelineLatency() const;
     int64_t getPipelinePosition(const std::string &format) const;
     int64_t getPipelineDuration(const std::string &format) const;
+    int64_t getTeardownDuration() const;
+    uint64_t getLoopCount() const;
+    uint64_t getStreamingThreadCount() const;
+    Pothos::ObjectKwargs getPortStats() const;
+    Pothos::ObjectKwargs getLatencyStats() const;
+    Pothos::ObjectKwargs getTracerStats() const;
+    Pothos::ObjectKwargs getElementTiming() const;
+    double getProcessingSpeed() const;
+    bool offlineMode() const;
+    bool measureLatency() const;
+    bool minimalMetadata() const;
+    size_t replicas() const;
+    const std::string& replicaKey() const;
+    GStreamerReplicas* replicaSet() const;
+    void replaceBin(const std::string &name, const std::string &description);
+    void seek(const std::string &format, int64_t position, double rate, const std::vector< std::string > &flags);
+    void setElementProperty(const std::string &name, const std::string &property, const Pothos::Object &value);
+    void setElementProperties(const std::string &name, const Pothos::ObjectKwargs &properties);
     std::string getPipelineGraph();
     void savePipelineGraph(const std::string &fileName);
 
@@ -0,0 +1,337 @@
+/// Copyright (c) 2017-2020 Ashley Brighthope
+/// SPDX-License-Identifier: BSL-1.0
+
+#include "GStreamerBinSwap.hpp"
+#include "GStreamerTypes.hpp"
+#include <Pothos/Exception.hpp>
+#include <atomic>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace GstBinSwap
+{
+    const char MESSAGE_SWAPPED[]{ "bin-swapped"     };
+    const char MESSAGE_FAILED []{ "bin-swap-failed" };
+}  // namespace GstBinSwap
+
+namespace
+{
+    using GstPadPtr = std::unique_ptr< GstPad, GstTypes::GstObjectUnrefFunc >;
+
+    //! @return The only pad of the element in the given direction, or nullptr if it has none or more than one
+    GstPad* getSinglePad(GstElement *element, GstPadDirection direction)
+    {
+        GstTypes::GstIteratorPtr gstIterator(
+            ( direction == GST_PAD_SINK ) ? gst_element_iterate_sink_pads( element ) : gst_element_iterate_src_pads( element )
+        );
+
+        GstPadPtr pad;
+        int count = 0;
+        GstTypes::GVal item;
+        while ( gst_iterator_next( gstIterator.get(), item() ) == GST_ITERATOR_OK )
+        {
+            if ( count++ == 0 )
+            {
+                pad.reset( GST_PAD( gst_object_ref( g_value_get_object( item() ) ) ) );
+            }
+        }
+        return ( count == 1 ) ? pad.release() : nullptr;
+    }
+
+    struct BinSwap;
+
+    //! Swaps in flight, by the element they replace. Entries expire once the swap is done or cancelled.
+    struct InFlight
+    {
+        std::mutex mutex;
+        std::map< GstElement*, std::weak_ptr< BinSwap > > swaps;
+    };
+
+    InFlight& inFlight()
+    {
+        static InFlight instance;
+        return instance;
+    }
+
+    /**
+     * State of one swap, owned by whichever pad probe or async call is due to run next.
+     * Holds references on the pipeline, its elements and pads until the swap is done,
+     * GstBinSwap::cancel drops the probes of a swap that never got data, so it does not keep the pipeline alive.
+     */
+    struct BinSwap final
+    {
+        using Ptr = std::shared_ptr< BinSwap >;
+        using GstPipelinePtr = std::unique_ptr< GstPipeline, GstTypes::GstObjectUnrefFunc >;
+        using GstBinPtr = std::unique_ptr< GstBin, GstTypes::GstObjectUnrefFunc >;
+
+        GstPipelinePtr pipeline;
+        GstBinPtr parent;
+        GstElement *key{ nullptr };
+        GstTypes::GstElementPtr oldElement;
+        GstTypes::GstElementPtr newElement;
+        GstPadPtr upstreamPad;
+        GstPadPtr downstreamPad;
+        GstPadPtr oldSinkPad;
+        GstPadPtr oldSrcPad;
+        std::string name;
+        gulong blockProbeId{ 0 };
+        gulong drainProbeId{ 0 };
+        std::atomic_bool draining{ false };
+        // Whoever gets to remove a probe first, the probe itself, the swap or cancel
+        std::atomic_bool blockRemoved{ false };
+        std::atomic_bool drainRemoved{ false };
+
+        BinSwap() = default;
+        BinSwap(const BinSwap&) = delete;
+        BinSwap& operator=(const BinSwap&) = delete;
+
+        ~BinSwap()
+        {
+            auto &registry = inFlight();
+            std::lock_guard< std::mutex > lock( registry.mutex );
+            const auto swap_it = registry.swaps.find( key );
+            // A new swap may already be registered for the same address
+            if ( swap_it != registry.swaps.end() && swap_it->second.expired() )
+            {
+                registry.swaps.erase( swap_it );
+            }
+        }
+
+        void removeBlockProbe()
+        {
+            if ( !blockRemoved.exchange( true ) )
+            {
+                gst_pad_remove_probe( upstreamPad.get(), blockProbeId );
+            }
+        }
+
+        void removeDrainProbe()
+        {
+            if ( drainProbeId != 0 && !drainRemoved.exchange( true ) )
+            {
+                gst_pad_remove_probe( oldSrcPad.get(), drainProbeId );
+            }
+        }
+
+        static gpointer share(const Ptr &swap)
+        {
+            return new Ptr( swap );
+        }
+
+        static void destroy(gpointer userData)
+        {
+            // NOLINTNEXTLINE(cppcoreguidelines-owning-memory)
+            delete static_cast< Ptr* >( userData );
+        }
+
+        static Ptr get(gpointer userData)
+        {
+            return *static_cast< Ptr* >( userData );
+        }
+
+        //! Upstream is blocked, drain what the old element holds by sending it an EOS
+        static GstPadProbeReturn blocked(GstPad * /* pad */, GstPadProbeInfo * /* info */, gpointer userData)
+        {
+            auto swap = get( userData );
+            // The pad stays blocked until the swap is done, only drain once
+            if ( swap->draining.exchange( true ) )
+            {
+                return GST_PAD_PROBE_OK;
+            }
+
+            swap->drainProbeId = gst_pad_add_probe(
+                swap->oldSrcPad.get(),
+                static_cast< GstPadProbeType >( GST_PAD_PROBE_TYPE_BLOCK | GST_PAD_PROBE_TYPE_EVENT_DOWNSTREAM ),
+                &BinSwap::drained,
+                share( swap ),
+                &BinSwap::destroy
+            );
+            gst_pad_send_event( swap->oldSinkPad.get(), gst_event_new_eos() );
+
+            return GST_PAD_PROBE_OK;
+        }
+
+        //! The EOS came out of the old element, it holds no more data
+        static GstPadProbeReturn drained(GstPad *pad, GstPadProbeInfo *info, gpointer userData)
+        {
+            if ( GST_EVENT_TYPE( GST_PAD_PROBE_INFO_EVENT( info ) ) != GST_EVENT_EOS )
+            {
+                return GST_PAD_PROBE_PASS;
+            }
+
+            // Removing the probe frees userData
+            auto swap = get( userData );
+            if ( swap->drainRemoved.exchange( true ) )
+            {
+                // Cancelled
+                return GST_PAD_PROBE_DROP;
+            }
+            gst_pad_remove_probe( pad, GST_PAD_PROBE_INFO_ID( info ) );
+
+            // The old element can not be stopped from its own streaming thread
+            gst_element_call_async(
+                GST_ELEMENT( swap->pipeline.get() ),
+                &BinSwap::swap,
+                share( swap ),
+                &BinSwap::destroy
+            );
+
+            // Don't let the EOS reach the rest of the pipeline
+            return GST_PAD_PROBE_DROP;
+        }
+
+        static void swap(GstElement * /* element */, gpointer userData)
+        {
+            auto swap = get( userData );
+            const auto error = swap->relink();
+
+            auto structure = gst_structure_new(
+                ( error.empty() ) ? GstBinSwap::MESSAGE_SWAPPED : GstBinSwap::MESSAGE_FAILED,
+                "name", G_TYPE_STRING, swap->name.c_str(),
+                nullptr
+            );
+            if ( !error.empty() )
+            {
+                gst_structure_set( structure, "error", G_TYPE_STRING, error.c_str(), nullptr );
+            }
+            gst_element_post_message(
+                GST_ELEMENT( swap->pipeline.get() ),
+                gst_message_new_application( GST_OBJECT( swap->pipeline.get() ), structure )
+            );
+
+            // Let the held back data through, to the new element
+            swap->removeBlockProbe();
+        }
+
+        //! @return Error, empty on success
+        std::string relink()
+        {
+            gst_element_set_state( oldElement.get(), GST_STATE_NULL );
+            // Unlinks the old element, then drop the last reference to it
+            gst_bin_remove( parent.get(), oldElement.get() );
+            oldElement.reset();
+
+            // Take over the name, so it can be replaced again
+            gst_object_set_name( GST_OBJECT( newElement.get() ), name.c_str() );
+            if ( gst_bin_add( parent.get(), newElement.get() ) == FALSE )
+            {
+                return "Could not add the new element to the pipeline";
+            }
+
+            GstPadPtr newSinkPad( getSinglePad( newElement.get(), GST_PAD_SINK ) );
+            GstPadPtr newSrcPad( getSinglePad( newElement.get(), GST_PAD_SRC ) );
+            const auto sinkLink = gst_pad_link( upstreamPad.get(), newSinkPad.get() );
+            if ( GST_PAD_LINK_FAILED( sinkLink ) )
+            {
+                return std::string( "Could not link the new element sink pad: " ) + gst_pad_link_get_name( sinkLink );
+            }
+            const auto srcLink = gst_pad_link( newSrcPad.get(), downstreamPad.get() );
+            if ( GST_PAD_LINK_FAILED( srcLink ) )
+            {
+                return std::string( "Could not link the new element source pad: " ) + gst_pad_link_get_name( srcLink );
+            }
+
+            if ( gst_element_sync_state_with_parent( newElement.get() ) == FALSE )
+            {
+                return "Could not change the state of the new element to the state of the pipeline";
+            }
+            return { };
+        }
+    };  // struct BinSwap
+
+}  // namespace
+
+namespace GstBinSwap
+{
+    void replace(GstPipeline *pipeline, GstElement *oldElement, GstElement *newElement)
+    {
+        const std::string funcName( "GstBinSwap::replace" );
+
+        auto swap = std::make_shared< BinSwap >();
+        // Own a reference, gst_bin_add takes its own
+        swap->newElement.reset( GST_ELEMENT( gst_object_ref_sink( newElement ) ) );
+        swap->pipeline.reset( GST_PIPELINE( gst_object_ref( pipeline ) ) );
+        swap->oldElement.reset( GST_ELEMENT( gst_object_ref( oldElement ) ) );
+        swap->name = GstTypes::gcharToString( GstTypes::GCharPtr( gst_element_get_name( oldElement ) ).get() ).value( "" );
+
+        std::unique_ptr< GstObject, GstTypes::GstObjectUnrefFunc > parent( gst_object_get_parent( GST_OBJECT( oldElement ) ) );
+        if ( !parent || !GST_IS_BIN( parent.get() ) )
+        {
+            throw Pothos::InvalidArgumentException( funcName, "\"" + swap->name + "\" is not in a bin" );
+        }
+        swap->parent.reset( GST_BIN( parent.get() ) );
+        parent.release();
+
+        swap->oldSinkPad.reset( getSinglePad( oldElement, GST_PAD_SINK ) );
+        swap->oldSrcPad.reset( getSinglePad( oldElement, GST_PAD_SRC ) );
+        if ( !swap->oldSinkPad || !swap->oldSrcPad )
+        {
+            throw Pothos::InvalidArgumentException( funcName, "\"" + swap->name + "\" must have a single sink and source pad" );
+        }
+
+        swap->upstreamPad.reset( gst_pad_get_peer( swap->oldSinkPad.get() ) );
+        swap->downstreamPad.reset( gst_pad_get_peer( swap->oldSrcPad.get() ) );
+        if ( !swap->upstreamPad || !swap->downstreamPad )
+        {
+            throw Pothos::InvalidArgumentException( funcName, "\"" + swap->name + "\" must be linked on both pads" );
+        }
+
+        const GstPadPtr newSinkPad( getSinglePad( newElement, GST_PAD_SINK ) );
+        const GstPadPtr newSrcPad( getSinglePad( newElement, GST_PAD_SRC ) );
+        if ( !newSinkPad || !newSrcPad )
+        {
+            throw Pothos::InvalidArgumentException( funcName, "Replacement for \"" + swap->name + "\" must have a single sink and source pad" );
+        }
+
+        // The old element is reffed by the swap, so its address can not be reused while the entry is live
+        {
+            auto &registry = inFlight();
+            std::lock_guard< std::mutex > lock( registry.mutex );
+            auto &entry = registry.swaps[ oldElement ];
+            if ( !entry.expired() )
+            {
+                throw Pothos::InvalidArgumentException( funcName, "\"" + swap->name + "\" is already being replaced" );
+            }
+            entry = swap;
+            swap->key = oldElement;
+        }
+
+        // Hold back the data upstream, the rest happens from the pad probes
+        swap->blockProbeId = gst_pad_add_probe(
+            swap->upstreamPad.get(),
+            GST_PAD_PROBE_TYPE_BLOCK_DOWNSTREAM,
+            &BinSwap::blocked,
+            BinSwap::share( swap ),
+            &BinSwap::destroy
+        );
+    }
+
+    void cancel(GstPipeline *pipeline)
+    {
+        std::vector< BinSwap::Ptr > swaps;
+        {
+            auto &registry = inFlight();
+            std::lock_guard< std::mutex > lock( registry.mutex );
+            // Don't drop references under the lock, the last one unregisters the swap
+            for (const auto &entry : registry.swaps)
+            {
+                auto swap = entry.second.lock();
+                if ( swap )
+                {
+                    swaps.push_back( std::move( swap ) );
+                }
+            }
+        }
+
+        for (const auto &swap : swaps)
+        {
+            if ( swap->pipeline.get() == pipeline )
+            {
+                swap->removeDrainProbe();
+                swap->removeBlockProbe();
+            }
+        }
+    }
+}  // namespace GstBinSwap
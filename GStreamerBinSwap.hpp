@@ -0,0 +1,39 @@
+/// Copyright (c) 2017-2020 Ashley Brighthope
+/// SPDX-License-Identifier: BSL-1.0
+
+#pragma once
+
+#include <gst/gst.h>
+#include <string>
+
+namespace GstBinSwap
+{
+    //! Name of the application message posted on the pipeline bus once a swap is done
+    extern const char MESSAGE_SWAPPED[];
+    //! Name of the application message posted on the pipeline bus if a swap failed
+    extern const char MESSAGE_FAILED[];
+
+    /**
+     * @brief Replace an element, or bin, of a running pipeline without stopping the pipeline.
+     *
+     * Data is held back upstream with a blocking pad probe, the old element is drained with an EOS,
+     * then swapped for the new element from a GStreamer thread and the data is let through again.
+     * Returns straight away, the outcome is posted on the pipeline bus as an application message.
+     *
+     * @param pipeline Pipeline containing the old element
+     * @param oldElement Element to replace, must have a single sink and source pad, both linked
+     * @param newElement Element to replace it with, must have a single sink and source pad. Takes ownership.
+     * @throws Pothos::InvalidArgumentException if the elements can not be swapped, or the old element is already being replaced
+     */
+    void replace(GstPipeline *pipeline, GstElement *oldElement, GstElement *newElement);
+
+    /**
+     * @brief Drop the swaps of a pipeline still waiting for data, so they release their references on it.
+     *
+     * Call once the pipeline is stopped, before dropping the last reference to it.
+     *
+     * @param pipeline Pipeline the swaps were started on
+     */
+    void cancel(GstPipeline *pipeline);
+
+}  // namespace GstBinSwap
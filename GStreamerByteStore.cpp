@@ -0,0 +1,103 @@
+/// Copyright (c) 2017-2020 Ashley Brighthope
+/// SPDX-License-Identifier: BSL-1.0
+
+#include "GStreamerByteStore.hpp"
+#include <Pothos/Exception.hpp>
+#include <algorithm>
+#include <memory>
+
+GStreamerByteStore::GStreamerByteStore() :
+    m_mutex( ),
+    m_mappedFile( nullptr ),
+    m_chunks( ),
+    m_size( 0 ),
+    m_complete( false )
+{
+}
+
+GStreamerByteStore::GStreamerByteStore(const std::string &fileName) :
+    m_mutex( ),
+    m_mappedFile( nullptr ),
+    m_chunks( ),
+    m_size( 0 ),
+    m_complete( true )
+{
+    GstTypes::GErrorPtr errorPtr;
+    m_mappedFile = g_mapped_file_new( fileName.c_str(), FALSE, GstTypes::uniqueOutArg( errorPtr ) );
+    if ( m_mappedFile == nullptr )
+    {
+        throw Pothos::InvalidArgumentException( "GStreamerByteStore::GStreamerByteStore(" + fileName + ")", GstTypes::gerrorToString( errorPtr.get() ) );
+    }
+    m_size = g_mapped_file_get_length( m_mappedFile );
+}
+
+GStreamerByteStore::~GStreamerByteStore()
+{
+    if ( m_mappedFile != nullptr )
+    {
+        g_mapped_file_unref( m_mappedFile );
+    }
+}
+
+void GStreamerByteStore::append(const Pothos::BufferChunk &chunk)
+{
+    if ( chunk.length == 0 )
+    {
+        return;
+    }
+
+    std::lock_guard< std::mutex > lock( m_mutex );
+    m_chunks.emplace( m_size, chunk );
+    m_size += chunk.length;
+}
+
+void GStreamerByteStore::setComplete()
+{
+    std::lock_guard< std::mutex > lock( m_mutex );
+    m_complete = true;
+}
+
+bool GStreamerByteStore::complete() const
+{
+    std::lock_guard< std::mutex > lock( m_mutex );
+    return m_complete;
+}
+
+uint64_t GStreamerByteStore::size() const
+{
+    std::lock_guard< std::mutex > lock( m_mutex );
+    return m_size;
+}
+
+GstTypes::GstBufferPtr GStreamerByteStore::read(uint64_t offset, size_t maxSize) const
+{
+    std::lock_guard< std::mutex > lock( m_mutex );
+    if ( offset >= m_size || maxSize == 0 )
+    {
+        return nullptr;
+    }
+
+    if ( m_mappedFile != nullptr )
+    {
+        const auto size = static_cast< size_t >( std::min< uint64_t >( maxSize, m_size - offset ) );
+        return GstTypes::GstBufferPtr(
+            gst_buffer_new_wrapped_full(
+                /*flags    =*/ GST_MEMORY_FLAG_READONLY,
+                /*data     =*/ g_mapped_file_get_contents( m_mappedFile ),
+                /*maxsize  =*/ m_size,
+                /*offset   =*/ offset,
+                /*size     =*/ size,
+                /*user_data=*/ g_mapped_file_ref( m_mappedFile ),
+                /*notify   =*/ reinterpret_cast< GDestroyNotify >( &g_mapped_file_unref )
+            )
+        );
+    }
+
+    // Chunk holding offset, the last one starting at or before it
+    auto chunk_it = m_chunks.upper_bound( offset );
+    --chunk_it;
+    const auto chunkOffset = static_cast< size_t >( offset - chunk_it->first );
+    const auto size = std::min( maxSize, chunk_it->second.length - chunkOffset );
+    auto chunk = std::make_shared< Pothos::BufferChunk >( chunk_it->second );
+    return GstTypes::makeSharedGstBuffer( chunk->as< const uint8_t* >() + chunkOffset, size, chunk );
+}
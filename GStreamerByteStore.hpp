@@ -0,0 +1,57 @@
+/// Copyright (c) 2017-2020 Ashley Brighthope
+/// SPDX-License-Identifier: BSL-1.0
+
+#pragma once
+
+#include "GStreamerTypes.hpp"
+#include <Pothos/Framework.hpp>
+#include <Poco/Optional.h>
+#include <gst/gst.h>
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <string>
+
+/**
+ * Bytes for a random access appsrc, read back from any offset.
+ * Either a memory mapped file, or the payloads of the Pothos packets received so far.
+ * Buffers read from the store share its memory, nothing is copied.
+ */
+class GStreamerByteStore final
+{
+private:
+    mutable std::mutex m_mutex;
+    GMappedFile *m_mappedFile;
+    std::map< uint64_t, Pothos::BufferChunk > m_chunks;
+    uint64_t m_size;
+    bool m_complete;
+
+public:
+    GStreamerByteStore(const GStreamerByteStore&) = delete;
+    GStreamerByteStore& operator=(const GStreamerByteStore&) = delete;
+
+    //! Store filled from Pothos packets with append()
+    GStreamerByteStore();
+
+    //! Store backed by a memory mapped file, complete from the start
+    explicit GStreamerByteStore(const std::string &fileName);
+
+    ~GStreamerByteStore();
+
+    void append(const Pothos::BufferChunk &chunk);
+
+    //! No more data will be appended, the size is final
+    void setComplete();
+    bool complete() const;
+
+    uint64_t size() const;
+
+    /**
+     * @brief Read from the store
+     * @param offset Offset to read from
+     * @param maxSize Maximum number of bytes to read, less may be returned
+     * @return Buffer with the bytes at offset, or nullptr if they are not in the store (yet)
+     */
+    GstTypes::GstBufferPtr read(uint64_t offset, size_t maxSize) const;
+
+};  // class GStreamerByteStore
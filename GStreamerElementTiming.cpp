@@ -0,0 +1,258 @@
+/// Copyright (c) 2017-2020 Ashley Brighthope
+/// SPDX-License-Identifier: BSL-1.0
+
+#include "GStreamerElementTiming.hpp"
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+
+struct GStreamerElementTiming::Element
+{
+    //! Arrivals kept for buffers not out yet, elements that take more buffers than they push drop the oldest
+    static constexpr size_t MAX_ARRIVALS = 1024;
+
+    std::mutex arrivalsMutex;
+    std::deque< uint64_t > arrivalsNs;
+    std::atomic< uint64_t > count{ 0 };
+    std::atomic< uint64_t > totalNs{ 0 };
+    std::atomic< uint64_t > maxNs{ 0 };
+    std::array< std::atomic< uint64_t >, HISTOGRAM_BINS > histogram{ };
+
+    void arrival(uint64_t ns)
+    {
+        std::lock_guard< std::mutex > lock( arrivalsMutex );
+        if ( arrivalsNs.size() == MAX_ARRIVALS )
+        {
+            arrivalsNs.pop_front();
+        }
+        arrivalsNs.push_back( ns );
+    }
+
+    bool departure(uint64_t &arrivalNs)
+    {
+        std::lock_guard< std::mutex > lock( arrivalsMutex );
+        if ( arrivalsNs.empty() )
+        {
+            return false;
+        }
+        arrivalNs = arrivalsNs.front();
+        arrivalsNs.pop_front();
+        return true;
+    }
+
+    void add(uint64_t ns)
+    {
+        count.fetch_add( 1, std::memory_order_relaxed );
+        totalNs.fetch_add( ns, std::memory_order_relaxed );
+        auto max = maxNs.load( std::memory_order_relaxed );
+        while ( ns > max && !maxNs.compare_exchange_weak( max, ns, std::memory_order_relaxed ) )
+        {
+        }
+
+        size_t bin = 0;
+        while ( ns != 0 && bin < HISTOGRAM_BINS - 1 )
+        {
+            ns >>= 1;
+            ++bin;
+        }
+        histogram[ bin ].fetch_add( 1, std::memory_order_relaxed );
+    }
+};
+
+struct GStreamerElementTiming::Probes
+{
+    std::mutex mutex;
+    // Cleared on detach, so a pad added while detaching is not probed
+    bool attached{ false };
+    std::vector< std::pair< GstPad*, gulong > > pads;
+
+    void add(GstPad *pad, const std::shared_ptr< Element > &elementTiming);
+    void removeAll();
+};
+
+namespace
+{
+    using ElementPtr = std::shared_ptr< GStreamerElementTiming::Element >;
+
+    // Probes can still be running on a streaming thread while being removed, so each holds a reference of its own
+    void destroyElementRef(gpointer data)
+    {
+        // NOLINTNEXTLINE(cppcoreguidelines-owning-memory)
+        delete static_cast< ElementPtr* >( data );
+    }
+
+    GstPadProbeReturn sinkPadProbe(GstPad * /* pad */, GstPadProbeInfo * /* info */, gpointer userData)
+    {
+        ( *static_cast< ElementPtr* >( userData ) )->arrival( gst_util_get_timestamp() );
+        return GST_PAD_PROBE_OK;
+    }
+
+    GstPadProbeReturn srcPadProbe(GstPad * /* pad */, GstPadProbeInfo * /* info */, gpointer userData)
+    {
+        auto &element = *static_cast< ElementPtr* >( userData );
+        const auto nowNs = gst_util_get_timestamp();
+        uint64_t arrivalNs = 0;
+        if ( element->departure( arrivalNs ) && nowNs >= arrivalNs )
+        {
+            element->add( nowNs - arrivalNs );
+        }
+        return GST_PAD_PROBE_OK;
+    }
+
+    // What the pad-added handler of an element needs, it can still be running on a streaming thread while being disconnected
+    struct PadAddedData
+    {
+        std::shared_ptr< GStreamerElementTiming::Probes > probes;
+        ElementPtr elementTiming;
+    };
+
+    void destroyPadAddedData(gpointer data, GClosure * /* closure */)
+    {
+        // NOLINTNEXTLINE(cppcoreguidelines-owning-memory)
+        delete static_cast< PadAddedData* >( data );
+    }
+
+    void padAdded(GstElement * /* element */, GstPad *pad, gpointer userData)
+    {
+        const auto &data = *static_cast< PadAddedData* >( userData );
+        data.probes->add( pad, data.elementTiming );
+    }
+}  // namespace
+
+void GStreamerElementTiming::Probes::add(GstPad *pad, const std::shared_ptr< Element > &elementTiming)
+{
+    std::lock_guard< std::mutex > lock( mutex );
+    const auto probed = [ pad ](const std::pair< GstPad*, gulong > &probe)
+    {
+        return probe.first == pad;
+    };
+    if ( !attached || std::any_of( pads.cbegin(), pads.cend(), probed ) )
+    {
+        return;
+    }
+
+    const auto probeId = gst_pad_add_probe(
+        pad,
+        static_cast< GstPadProbeType >( GST_PAD_PROBE_TYPE_BUFFER | GST_PAD_PROBE_TYPE_BUFFER_LIST ),
+        ( GST_PAD_IS_SINK( pad ) ) ? &sinkPadProbe : &srcPadProbe,
+        new ElementPtr( elementTiming ),
+        &destroyElementRef
+    );
+    if ( probeId != 0 )
+    {
+        pads.emplace_back( GST_PAD( gst_object_ref( pad ) ), probeId );
+    }
+}
+
+void GStreamerElementTiming::Probes::removeAll()
+{
+    std::lock_guard< std::mutex > lock( mutex );
+    attached = false;
+    for (const auto &probe : pads)
+    {
+        gst_pad_remove_probe( probe.first, probe.second );
+        gst_object_unref( probe.first );
+    }
+    pads.clear();
+}
+
+GStreamerElementTiming::GStreamerElementTiming() :
+    m_elements( ),
+    m_probes( std::make_shared< Probes >() ),
+    m_padAddedHandlers( )
+{
+}
+
+GStreamerElementTiming::~GStreamerElementTiming()
+{
+    detach();
+}
+
+void GStreamerElementTiming::attachElement(GstElement *element)
+{
+    const auto elementTiming = std::make_shared< Element >();
+    m_elements[ GstTypes::elementPath( element ) ] = elementTiming;
+
+    // Connected before the pads are listed, so a pad added in between is not missed
+    const auto handlerId = g_signal_connect_data(
+        element,
+        "pad-added",
+        G_CALLBACK( &padAdded ),
+        new PadAddedData{ m_probes, elementTiming },
+        &destroyPadAddedData,
+        static_cast< GConnectFlags >( 0 )
+    );
+    m_padAddedHandlers.emplace_back( GstTypes::GstElementPtr( GST_ELEMENT( gst_object_ref( element ) ) ), handlerId );
+
+    std::vector< GstPad* > pads;
+    GST_OBJECT_LOCK( element );
+    for (auto *pad_it = GST_ELEMENT_PADS( element ); pad_it != nullptr; pad_it = pad_it->next)
+    {
+        pads.push_back( GST_PAD( gst_object_ref( pad_it->data ) ) );
+    }
+    GST_OBJECT_UNLOCK( element );
+
+    for (auto *pad : pads)
+    {
+        m_probes->add( pad, elementTiming );
+        gst_object_unref( pad );
+    }
+}
+
+void GStreamerElementTiming::attach(const std::vector< GstTypes::GstElementPtr > &elements)
+{
+    detach();
+    m_elements.clear();
+    {
+        std::lock_guard< std::mutex > lock( m_probes->mutex );
+        m_probes->attached = true;
+    }
+    for (const auto &element : elements)
+    {
+        attachElement( element.get() );
+    }
+}
+
+void GStreamerElementTiming::detach()
+{
+    for (const auto &handler : m_padAddedHandlers)
+    {
+        g_signal_handler_disconnect( handler.first.get(), handler.second );
+    }
+    m_padAddedHandlers.clear();
+    m_probes->removeAll();
+}
+
+bool GStreamerElementTiming::attached() const
+{
+    std::lock_guard< std::mutex > lock( m_probes->mutex );
+    return m_probes->attached;
+}
+
+Pothos::ObjectKwargs GStreamerElementTiming::toObjectKwargs() const
+{
+    Pothos::ObjectKwargs timing;
+    for (const auto &element : m_elements)
+    {
+        const auto count = element.second->count.load( std::memory_order_relaxed );
+        const auto totalNs = element.second->totalNs.load( std::memory_order_relaxed );
+
+        Pothos::ObjectVector histogram;
+        histogram.reserve( HISTOGRAM_BINS );
+        for (const auto &bin : element.second->histogram)
+        {
+            histogram.emplace_back( bin.load( std::memory_order_relaxed ) );
+        }
+
+        Pothos::ObjectKwargs elementTiming;
+        elementTiming[ "count"     ] = Pothos::Object( count );
+        elementTiming[ "meanNs"    ] = Pothos::Object( ( count == 0 ) ? uint64_t( 0 ) : totalNs / count );
+        elementTiming[ "maxNs"     ] = Pothos::Object( element.second->maxNs.load( std::memory_order_relaxed ) );
+        elementTiming[ "histogram" ] = Pothos::Object( histogram );
+        timing[ element.first ] = Pothos::Object( elementTiming );
+    }
+    return timing;
+}
@@ -0,0 +1,66 @@
+/// Copyright (c) 2017-2020 Ashley Brighthope
+/// SPDX-License-Identifier: BSL-1.0
+
+#pragma once
+
+#include "GStreamerTypes.hpp"
+#include <gst/gst.h>
+#include <Pothos/Framework.hpp>
+#include <cstddef>
+#include <map>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+/**
+ * Time spent in each of a set of elements, from buffer pad probes on their pads.
+ * Buffers reaching a sink pad of the element are queued by arrival, each buffer leaving a src pad is timed from the oldest,
+ * so for elements that push from their chain function it is the processing time,
+ * and for elements with a queue and streaming thread of their own it includes the time in the queue.
+ * Pairing the n-th buffer in with the n-th out only holds for elements that push one buffer out for each in,
+ * the times of others, e.g. encoders or tee, are off.
+ * Pads added while attached, e.g. request and sometimes pads, are probed too.
+ * The probes are removed on detach, leaving no overhead behind, the times are kept until the next attach.
+ */
+class GStreamerElementTiming final
+{
+public:
+    //! Histogram bins, bin n counts times of 2^(n-1) to 2^n nanoseconds
+    static constexpr size_t HISTOGRAM_BINS = 32;
+
+    //! Times of one element, updated from its pad probes
+    struct Element;
+
+    //! The pad probes, also added from streaming threads as pads get added
+    struct Probes;
+
+private:
+    // By element path, so elements of the same name in different bins are kept apart
+    std::map< std::string, std::shared_ptr< Element > > m_elements;
+    std::shared_ptr< Probes > m_probes;
+    std::vector< std::pair< GstTypes::GstElementPtr, gulong > > m_padAddedHandlers;
+
+    void attachElement(GstElement *element);
+
+public:
+    GStreamerElementTiming(const GStreamerElementTiming&) = delete;
+    GStreamerElementTiming& operator=(const GStreamerElementTiming&) = delete;
+
+    GStreamerElementTiming();
+    ~GStreamerElementTiming();
+
+    //! Start timing these elements, instead of the ones before, the times start from zero
+    void attach(const std::vector< GstTypes::GstElementPtr > &elements);
+
+    //! Remove the pad probes, keeping the times
+    void detach();
+
+    bool attached() const;
+
+    /**
+     * @return {element path: {"count", "meanNs", "maxNs", "histogram": [HISTOGRAM_BINS counts]}}
+     */
+    Pothos::ObjectKwargs toObjectKwargs() const;
+
+};  // class GStreamerElementTiming
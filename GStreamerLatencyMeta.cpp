@@ -0,0 +1,102 @@
+/// Copyright (c) 2017-2020 Ashley Brighthope
+/// SPDX-License-Identifier: BSL-1.0
+
+#include "GStreamerLatencyMeta.hpp"
+#include <algorithm>
+#include <chrono>
+
+namespace
+{
+    struct PothosLatencyMeta
+    {
+        GstMeta meta;
+        gint64 pushTimeNs;
+    };
+
+    GType latencyMetaApiType()
+    {
+        static const GType type = []()
+        {
+            // No tags, so transforms of any kind keep it
+            static const gchar *tags[] = { nullptr };
+            return gst_meta_api_type_register( "PothosLatencyMetaAPI", tags );
+        }();
+        return type;
+    }
+
+    gboolean latencyMetaInit(GstMeta *meta, gpointer /* params */, GstBuffer * /* buffer */)
+    {
+        reinterpret_cast< PothosLatencyMeta* >( meta )->pushTimeNs = 0;
+        return TRUE;
+    }
+
+    PothosLatencyMeta* getLatencyMeta(GstBuffer *buffer)
+    {
+        return reinterpret_cast< PothosLatencyMeta* >( gst_buffer_get_meta( buffer, latencyMetaApiType() ) );
+    }
+
+    const GstMetaInfo* latencyMetaInfo();
+
+    void setPushTime(GstBuffer *buffer, gint64 pushTimeNs)
+    {
+        auto *latencyMeta = getLatencyMeta( buffer );
+        if ( latencyMeta == nullptr )
+        {
+            latencyMeta = reinterpret_cast< PothosLatencyMeta* >( gst_buffer_add_meta( buffer, latencyMetaInfo(), nullptr ) );
+            if ( latencyMeta == nullptr )
+            {
+                return;
+            }
+            latencyMeta->pushTimeNs = pushTimeNs;
+            return;
+        }
+        latencyMeta->pushTimeNs = std::min( latencyMeta->pushTimeNs, pushTimeNs );
+    }
+
+    gboolean latencyMetaTransform(GstBuffer *transbuf, GstMeta *meta, GstBuffer * /* buffer */, GQuark /* type */, gpointer /* data */)
+    {
+        setPushTime( transbuf, reinterpret_cast< PothosLatencyMeta* >( meta )->pushTimeNs );
+        return TRUE;
+    }
+
+    const GstMetaInfo* latencyMetaInfo()
+    {
+        static const GstMetaInfo *info = gst_meta_register(
+            latencyMetaApiType(),
+            "PothosLatencyMeta",
+            sizeof( PothosLatencyMeta ),
+            &latencyMetaInit,
+            nullptr,
+            &latencyMetaTransform
+        );
+        return info;
+    }
+}  // namespace
+
+namespace GstLatencyMeta
+{
+    int64_t nowNs()
+    {
+        return std::chrono::duration_cast< std::chrono::nanoseconds >( std::chrono::steady_clock::now().time_since_epoch() ).count();
+    }
+
+    void stamp(GstBuffer *buffer)
+    {
+        setPushTime( buffer, nowNs() );
+    }
+
+    Poco::Optional< int64_t > elapsedNs(GstBuffer *buffer)
+    {
+        if ( buffer == nullptr )
+        {
+            return {};
+        }
+        const auto *latencyMeta = getLatencyMeta( buffer );
+        if ( latencyMeta == nullptr )
+        {
+            return {};
+        }
+        return std::max< int64_t >( 0, nowNs() - latencyMeta->pushTimeNs );
+    }
+
+}  // namespace GstLatencyMeta
@@ -0,0 +1,27 @@
+/// Copyright (c) 2017-2020 Ashley Brighthope
+/// SPDX-License-Identifier: BSL-1.0
+
+#pragma once
+
+#include <gst/gst.h>
+#include <Poco/Optional.h>
+#include <cstdint>
+
+/**
+ * GstMeta holding the time a buffer was pushed into the pipeline by an appsrc,
+ * read back when the buffer, or one made from it, comes out of an appsink.
+ * The meta has no tags, so it is kept by elements that make new buffers from old ones, e.g. encoders.
+ * When buffers are merged the earliest time is kept.
+ */
+namespace GstLatencyMeta
+{
+    //! @return Steady clock time in nanoseconds, the clock the stamps are taken from
+    int64_t nowNs();
+
+    //! Stamp a writable buffer with the current time
+    void stamp(GstBuffer *buffer);
+
+    //! @return Nanoseconds since the buffer was stamped, none if it was not
+    Poco::Optional< int64_t > elapsedNs(GstBuffer *buffer);
+
+}  // namespace GstLatencyMeta
@@ -0,0 +1,244 @@
+/// Copyright (c) 2017-2020 Ashley Brighthope
+/// SPDX-License-Identifier: BSL-1.0
+
+#include "GStreamerPipelineDescription.hpp"
+#include <algorithm>
+#include <cctype>
+#include <string>
+#include <vector>
+
+namespace
+{
+    struct Token
+    {
+        enum class Kind
+        {
+            WORD,
+            LINK,
+            BIN_OPEN,
+            BIN_CLOSE
+        };
+
+        Kind kind;
+        std::string text;
+    };  // struct Token
+
+    /**
+     * Split a pipeline description into words, links and bin brackets.
+     * Quotes are removed and escaped characters are kept.
+     * Returns false if a quote is not terminated.
+     */
+    bool tokenize(const std::string &pipelineString, std::vector< Token > &tokens)
+    {
+        std::string word;
+        bool inWord = false;
+        bool pendingAssignment = false;
+        // In the "(type)" of a value, e.g. "rate=(int)8000", which is not a bin
+        bool inValueType = false;
+
+        const auto endWord = [ &word, &inWord, &inValueType, &tokens ]()
+        {
+            if ( inWord )
+            {
+                tokens.push_back( { Token::Kind::WORD, word } );
+                word.clear();
+                inWord = false;
+            }
+            inValueType = false;
+        };
+
+        for ( std::string::size_type i = 0; i < pipelineString.size(); ++i )
+        {
+            const char c = pipelineString[ i ];
+
+            if ( std::isspace( static_cast< unsigned char >( c ) ) != 0 )
+            {
+                if ( inWord && ( word.back() == '=' ) )
+                {
+                    // "key= value", keep collecting the value into this word
+                    pendingAssignment = true;
+                }
+                endWord();
+                continue;
+            }
+
+            switch ( c )
+            {
+                case '!':
+                    endWord();
+                    tokens.push_back( { Token::Kind::LINK, { } } );
+                    pendingAssignment = false;
+                    continue;
+                case '(':
+                    if ( pendingAssignment || ( inWord && ( word.back() == '=' || word.back() == ',' ) ) )
+                    {
+                        inValueType = true;
+                        break;
+                    }
+                    endWord();
+                    tokens.push_back( { Token::Kind::BIN_OPEN, { } } );
+                    pendingAssignment = false;
+                    continue;
+                case ')':
+                    if ( inValueType )
+                    {
+                        inValueType = false;
+                        break;
+                    }
+                    endWord();
+                    tokens.push_back( { Token::Kind::BIN_CLOSE, { } } );
+                    pendingAssignment = false;
+                    continue;
+                default:
+                    break;
+            }
+
+            // "key =value" or "key = value", join with the last word
+            if ( !inWord && ( c == '=' || pendingAssignment ) &&
+                 !tokens.empty() && ( tokens.back().kind == Token::Kind::WORD ) )
+            {
+                word = tokens.back().text;
+                tokens.pop_back();
+            }
+            pendingAssignment = false;
+            inWord = true;
+
+            if ( c == '"' || c == '\'' )
+            {
+                const auto quote = c;
+                for ( ++i; ; ++i )
+                {
+                    if ( i >= pipelineString.size() )
+                    {
+                        return false;
+                    }
+                    if ( pipelineString[ i ] == quote )
+                    {
+                        break;
+                    }
+                    if ( ( pipelineString[ i ] == '\\' ) && ( ( i + 1 ) < pipelineString.size() ) )
+                    {
+                        ++i;
+                    }
+                    word += pipelineString[ i ];
+                }
+                continue;
+            }
+
+            if ( ( c == '\\' ) && ( ( i + 1 ) < pipelineString.size() ) )
+            {
+                ++i;
+            }
+            word += pipelineString[ i ];
+        }
+        endWord();
+
+        return true;
+    }
+
+    bool isFactoryName(const std::string &word)
+    {
+        return std::all_of( word.cbegin(), word.cend(), [ ](char c)
+        {
+            return ( std::isalnum( static_cast< unsigned char >( c ) ) != 0 ) || c == '-' || c == '_';
+        } );
+    }
+
+    bool isPropertyName(const std::string &word)
+    {
+        if ( word.empty() || ( std::isalpha( static_cast< unsigned char >( word.front() ) ) == 0 ) )
+        {
+            return false;
+        }
+        return std::all_of( word.cbegin(), word.cend(), [ ](char c)
+        {
+            return ( std::isalnum( static_cast< unsigned char >( c ) ) != 0 ) || c == '-' || c == '_' || c == ':';
+        } );
+    }
+
+    struct Element
+    {
+        std::string factory;
+        std::string name;
+        bool named;
+    };  // struct Element
+
+}  // namespace
+
+namespace GstPipelineDescription
+{
+    Poco::Optional< Description > parse(const std::string &pipelineString)
+    {
+        std::vector< Token > tokens;
+        if ( !tokenize( pipelineString, tokens ) )
+        {
+            return { };
+        }
+
+        std::vector< Element > elements;
+        // Index into elements of the element properties are applied to, or none if properties belong to a bin, caps or reference
+        Poco::Optional< std::vector< Element >::size_type > currentElement;
+
+        for ( const auto &token : tokens )
+        {
+            if ( token.kind != Token::Kind::WORD )
+            {
+                currentElement.clear();
+                continue;
+            }
+
+            const auto &word = token.text;
+            const auto assignment = word.find( '=' );
+            if ( ( assignment != std::string::npos ) && isPropertyName( word.substr( 0, assignment ) ) )
+            {
+                if ( currentElement.isSpecified() && ( word.compare( 0, assignment, "name" ) == 0 ) )
+                {
+                    auto &element = elements[ currentElement.value() ];
+                    element.name = word.substr( assignment + 1 );
+                    element.named = true;
+                }
+                continue;
+            }
+
+            // Caps filters, URIs and element references can not be appsrc or appsink
+            if ( !isFactoryName( word ) )
+            {
+                currentElement.clear();
+                continue;
+            }
+
+            elements.push_back( { word, { }, false } );
+            currentElement = elements.size() - 1;
+        }
+
+        Description description;
+        for ( const auto &element : elements )
+        {
+            const bool isAppSrc  = ( element.factory == "appsrc"  );
+            const bool isAppSink = ( element.factory == "appsink" );
+
+            // GStreamer will give unnamed elements a name we can not predict
+            if ( ( isAppSrc || isAppSink ) && ( !element.named || element.name.empty() ) )
+            {
+                return { };
+            }
+
+            if ( isAppSrc )
+            {
+                description.appSrcNames.push_back( element.name );
+            }
+            else if ( isAppSink )
+            {
+                description.appSinkNames.push_back( element.name );
+            }
+
+            if ( std::find( description.factories.cbegin(), description.factories.cend(), element.factory ) == description.factories.cend() )
+            {
+                description.factories.push_back( element.factory );
+            }
+        }
+
+        return description;
+    }
+
+}  // namespace GstPipelineDescription
@@ -0,0 +1,30 @@
+/// Copyright (c) 2017-2020 Ashley Brighthope
+/// SPDX-License-Identifier: BSL-1.0
+
+#pragma once
+
+#include <Poco/Optional.h>
+#include <string>
+#include <vector>
+
+namespace GstPipelineDescription
+{
+    struct Description
+    {
+        //! Names of the appsrc elements, in the order they appear in the description
+        std::vector< std::string > appSrcNames;
+        //! Names of the appsink elements, in the order they appear in the description
+        std::vector< std::string > appSinkNames;
+        //! Element factory names used by the description
+        std::vector< std::string > factories;
+    };  // struct Description
+
+    /**
+     * @brief Lightweight scan of a gst-launch style pipeline description, no GStreamer elements are created.
+     * @param pipelineString Pipeline description as given to gst_parse_launch
+     * @return Description if every appsrc and appsink could be resolved to a name,
+     *         otherwise nothing and the caller must create the pipeline to find them.
+     */
+    Poco::Optional< Description > parse(const std::string &pipelineString);
+
+}  // namespace GstPipelineDescription
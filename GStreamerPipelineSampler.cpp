@@ -0,0 +1,135 @@
+/// Copyright (c) 2017-2020 Ashley Brighthope
+/// SPDX-License-Identifier: BSL-1.0
+
+#include "GStreamerPipelineSampler.hpp"
+#include "GStreamerTypes.hpp"
+#include <gst/gst.h>
+#include <utility>
+
+namespace GstPipelineQuery
+{
+    Pothos::Object latency(GstElement *element)
+    {
+        std::unique_ptr < GstQuery, GstTypes::detail::Deleter< GstQuery, gst_query_unref > > query( gst_query_new_latency() );
+        const auto res = gst_element_query( element, query.get() );
+        if (res == FALSE)
+        {
+            return Pothos::Object();
+        }
+
+        gboolean live;
+        GstClockTime min_latency;
+        GstClockTime max_latency;
+        gst_query_parse_latency(query.get(), &live, &min_latency, &max_latency);
+
+        Pothos::ObjectKwargs args;
+        args["live"       ] = Pothos::Object( static_cast< bool >( live ) );
+        args["min_latency"] = GstTypes::gstClockTimeToObject( min_latency );
+        args["max_latency"] = GstTypes::gstClockTimeToObject( max_latency );
+        return Pothos::Object::make( args );
+    }
+
+    Poco::Optional< int64_t > position(GstElement *element, GstFormat format)
+    {
+        gint64 position;
+        if ( gst_element_query_position( element, format, &position ) == TRUE )
+        {
+            return position;
+        }
+        return { };
+    }
+
+    Poco::Optional< int64_t > duration(GstElement *element, GstFormat format)
+    {
+        gint64 duration;
+        if ( gst_element_query_duration( element, format, &duration ) == TRUE )
+        {
+            return duration;
+        }
+        return { };
+    }
+}  // namespace GstPipelineQuery
+
+GStreamerPipelineSampler::GStreamerPipelineSampler(GstPipeline *pipeline, double rateHz) :
+    m_pipeline( GST_PIPELINE( gst_object_ref( pipeline ) ) ),
+    m_period( std::chrono::duration_cast< std::chrono::nanoseconds >( std::chrono::duration< double >( 1.0 / rateHz ) ) ),
+    m_mutex( ),
+    m_cond( ),
+    m_stop( false ),
+    m_formats( { GST_FORMAT_TIME } ),
+    m_snapshot( ),
+    m_thread( )
+{
+    m_thread = std::thread( &GStreamerPipelineSampler::run, this );
+}
+
+GStreamerPipelineSampler::~GStreamerPipelineSampler()
+{
+    {
+        std::lock_guard< std::mutex > lock( m_mutex );
+        m_stop = true;
+    }
+    m_cond.notify_one();
+    m_thread.join();
+}
+
+void GStreamerPipelineSampler::run()
+{
+    auto element = GST_ELEMENT( m_pipeline.get() );
+
+    std::unique_lock< std::mutex > lock( m_mutex );
+    while ( !m_stop )
+    {
+        const auto formats = m_formats;
+        lock.unlock();
+
+        // Query without holding the lock, so probes never wait on the pipeline
+        Snapshot snapshot;
+        snapshot.latency = GstPipelineQuery::latency( element );
+        for (const auto format : formats)
+        {
+            snapshot.position[ format ] = GstPipelineQuery::position( element, format );
+            snapshot.duration[ format ] = GstPipelineQuery::duration( element, format );
+        }
+
+        lock.lock();
+        m_snapshot = std::move( snapshot );
+        m_cond.wait_for( lock, m_period, [ this ]() { return m_stop; } );
+    }
+}
+
+Pothos::Object GStreamerPipelineSampler::latency() const
+{
+    std::lock_guard< std::mutex > lock( m_mutex );
+    return m_snapshot.latency;
+}
+
+Poco::Optional< int64_t > GStreamerPipelineSampler::position(GstFormat format)
+{
+    {
+        std::lock_guard< std::mutex > lock( m_mutex );
+        const auto it = m_snapshot.position.find( format );
+        if ( it != m_snapshot.position.cend() )
+        {
+            return it->second;
+        }
+        // First time this format is asked for, sample it from now on
+        m_formats.insert( format );
+    }
+    return GstPipelineQuery::position( GST_ELEMENT( m_pipeline.get() ), format );
+}
+
+Poco::Optional< int64_t > GStreamerPipelineSampler::duration(GstFormat format)
+{
+    {
+        std::lock_guard< std::mutex > lock( m_mutex );
+        const auto it = m_snapshot.duration.find( format );
+        if ( it != m_snapshot.duration.cend() )
+        {
+            return it->second;
+        }
+        // First time this format is asked for, sample it from now on
+        m_formats.insert( format );
+    }
+    return GstPipelineQuery::duration( GST_ELEMENT( m_pipeline.get() ), format );
+}
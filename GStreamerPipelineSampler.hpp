@@ -0,0 +1,64 @@
+/// Copyright (c) 2017-2020 Ashley Brighthope
+/// SPDX-License-Identifier: BSL-1.0
+
+#pragma once
+
+#include "GStreamerTypes.hpp"
+#include <Pothos/Framework.hpp>
+#include <Poco/Optional.h>
+#include <gst/gst.h>
+#include <chrono>
+#include <condition_variable>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <thread>
+
+namespace GstPipelineQuery
+{
+    Pothos::Object latency(GstElement *element);
+    Poco::Optional< int64_t > position(GstElement *element, GstFormat format);
+    Poco::Optional< int64_t > duration(GstElement *element, GstFormat format);
+}  // namespace GstPipelineQuery
+
+/**
+ * Queries position, duration and latency of a pipeline from a background thread at a fixed rate,
+ * so probes can return the last values without querying the pipeline from the caller's thread.
+ */
+class GStreamerPipelineSampler final
+{
+private:
+    struct Snapshot
+    {
+        Pothos::Object latency;
+        std::map< GstFormat, Poco::Optional< int64_t > > position;
+        std::map< GstFormat, Poco::Optional< int64_t > > duration;
+    };  // struct Snapshot
+
+    std::unique_ptr< GstPipeline, GstTypes::GstObjectUnrefFunc > m_pipeline;
+    const std::chrono::nanoseconds m_period;
+    mutable std::mutex m_mutex;
+    std::condition_variable m_cond;
+    bool m_stop;
+    std::set< GstFormat > m_formats;
+    Snapshot m_snapshot;
+    std::thread m_thread;
+
+    void run();
+
+public:
+    GStreamerPipelineSampler() = delete;
+    GStreamerPipelineSampler(const GStreamerPipelineSampler&) = delete;
+    GStreamerPipelineSampler& operator=(const GStreamerPipelineSampler&) = delete;
+    GStreamerPipelineSampler(GStreamerPipelineSampler&&) = delete;
+    GStreamerPipelineSampler& operator=(GStreamerPipelineSampler&&) = delete;
+
+    GStreamerPipelineSampler(GstPipeline *pipeline, double rateHz);
+    ~GStreamerPipelineSampler();
+
+    Pothos::Object latency() const;
+    Poco::Optional< int64_t > position(GstFormat format);
+    Poco::Optional< int64_t > duration(GstFormat format);
+
+};  // class GStreamerPipelineSampler
@@ -0,0 +1,191 @@
+/// Copyright (c) 2017-2020 Ashley Brighthope
+/// SPDX-License-Identifier: BSL-1.0
+
+#include "GStreamerPortStats.hpp"
+#include <Pothos/Plugin.hpp>
+#include <algorithm>
+#include <chrono>
+#include <utility>
+
+namespace
+{
+    int64_t nowNs()
+    {
+        return std::chrono::duration_cast< std::chrono::nanoseconds >( std::chrono::steady_clock::now().time_since_epoch() ).count();
+    }
+
+    template< size_t N >
+    Pothos::ObjectVector histogramToObjectVector(const std::array< std::atomic< uint64_t >, N > &histogram)
+    {
+        Pothos::ObjectVector objects;
+        objects.reserve( N );
+        for (const auto &bin : histogram)
+        {
+            objects.emplace_back( bin.load( std::memory_order_relaxed ) );
+        }
+        return objects;
+    }
+
+    GStreamerPortStats::AllocationCounter findAllocationCounter()
+    {
+        const std::string path( GStreamerPortStats::ALLOCATION_COUNTER_PATH );
+        if ( !Pothos::PluginRegistry::exists( path ) )
+        {
+            return nullptr;
+        }
+        const auto counter = Pothos::PluginRegistry::get( path ).getObject();
+        return ( counter.type() == typeid( GStreamerPortStats::AllocationCounter ) ) ? counter.extract< GStreamerPortStats::AllocationCounter >() : nullptr;
+    }
+}  // namespace
+
+const char GStreamerPortStats::ALLOCATION_COUNTER_PATH[]{ "/media/gstreamer/allocation_counter" };
+
+GStreamerPortStats::GStreamerPortStats() :
+    m_buffers( 0 ),
+    m_bytes( 0 ),
+    m_drops( 0 ),
+    m_flowErrors( 0 ),
+    m_allocationCounter( findAllocationCounter() ),
+    m_allocations( 0 ),
+    m_lastArrivalNs( 0 ),
+    m_occupancy( ),
+    m_interArrival( ),
+    m_latencyMutex( ),
+    m_latencyWindow( ),
+    m_latencyNext( 0 ),
+    m_latencyCount( 0 ),
+    m_latencyMaxNs( 0 )
+{
+    reset();
+}
+
+void GStreamerPortStats::reset()
+{
+    m_buffers = 0;
+    m_bytes = 0;
+    m_drops = 0;
+    m_flowErrors = 0;
+    m_allocations = 0;
+    m_lastArrivalNs = 0;
+    for (auto &bin : m_occupancy)
+    {
+        bin = 0;
+    }
+    for (auto &bin : m_interArrival)
+    {
+        bin = 0;
+    }
+
+    std::lock_guard< std::mutex > lock( m_latencyMutex );
+    m_latencyWindow.clear();
+    m_latencyNext = 0;
+    m_latencyCount = 0;
+    m_latencyMaxNs = 0;
+}
+
+void GStreamerPortStats::buffer(size_t bytes)
+{
+    m_buffers.fetch_add( 1, std::memory_order_relaxed );
+    m_bytes.fetch_add( bytes, std::memory_order_relaxed );
+
+    const auto now = nowNs();
+    const auto last = m_lastArrivalNs.exchange( now, std::memory_order_relaxed );
+    if ( last == 0 )
+    {
+        return;
+    }
+
+    // log2 bins of microseconds
+    auto gapUs = static_cast< uint64_t >( std::max< int64_t >( 0, now - last ) / 1000 );
+    size_t bin = 0;
+    while ( gapUs != 0 && bin < INTER_ARRIVAL_BINS - 1 )
+    {
+        gapUs >>= 1;
+        ++bin;
+    }
+    m_interArrival[ bin ].fetch_add( 1, std::memory_order_relaxed );
+}
+
+void GStreamerPortStats::drop()
+{
+    m_drops.fetch_add( 1, std::memory_order_relaxed );
+}
+
+void GStreamerPortStats::flowError()
+{
+    m_flowErrors.fetch_add( 1, std::memory_order_relaxed );
+}
+
+void GStreamerPortStats::occupancy(double fraction)
+{
+    // Also catches NaN, from a queue without a limit
+    if ( !( fraction > 0.0 ) )
+    {
+        fraction = 0.0;
+    }
+    const auto bin = static_cast< size_t >( std::min( fraction, 1.0 ) * ( OCCUPANCY_BINS - 1 ) + 0.5 );
+    m_occupancy[ bin ].fetch_add( 1, std::memory_order_relaxed );
+}
+
+void GStreamerPortStats::latency(int64_t ns)
+{
+    std::lock_guard< std::mutex > lock( m_latencyMutex );
+    if ( m_latencyWindow.size() < LATENCY_WINDOW )
+    {
+        m_latencyWindow.push_back( ns );
+    }
+    else
+    {
+        m_latencyWindow[ m_latencyNext ] = ns;
+    }
+    m_latencyNext = ( m_latencyNext + 1 ) % LATENCY_WINDOW;
+    ++m_latencyCount;
+    m_latencyMaxNs = std::max( m_latencyMaxNs, ns );
+}
+
+Pothos::ObjectKwargs GStreamerPortStats::latencyToObjectKwargs() const
+{
+    std::vector< int64_t > window;
+    Pothos::ObjectKwargs latency;
+    {
+        std::lock_guard< std::mutex > lock( m_latencyMutex );
+        if ( m_latencyCount == 0 )
+        {
+            return latency;
+        }
+        window = m_latencyWindow;
+        latency[ "samples" ] = Pothos::Object( m_latencyCount );
+        latency[ "max"     ] = Pothos::Object( m_latencyMaxNs );
+    }
+
+    const auto percentile = [&window](double fraction)
+    {
+        const auto nth = window.begin() + static_cast< std::ptrdiff_t >( fraction * static_cast< double >( window.size() - 1 ) + 0.5 );
+        std::nth_element( window.begin(), nth, window.end() );
+        return *nth;
+    };
+    latency[ "p50" ] = Pothos::Object( percentile( 0.50 ) );
+    latency[ "p99" ] = Pothos::Object( percentile( 0.99 ) );
+    return latency;
+}
+
+Pothos::ObjectKwargs GStreamerPortStats::toObjectKwargs() const
+{
+    Pothos::ObjectKwargs stats;
+    stats[ "buffers"               ] = Pothos::Object( m_buffers.load( std::memory_order_relaxed ) );
+    stats[ "bytes"                 ] = Pothos::Object( m_bytes.load( std::memory_order_relaxed ) );
+    stats[ "drops"                 ] = Pothos::Object( m_drops.load( std::memory_order_relaxed ) );
+    stats[ "flowErrors"            ] = Pothos::Object( m_flowErrors.load( std::memory_order_relaxed ) );
+    stats[ "occupancyHistogram"    ] = Pothos::Object( histogramToObjectVector( m_occupancy ) );
+    stats[ "interArrivalHistogram" ] = Pothos::Object( histogramToObjectVector( m_interArrival ) );
+    if ( m_allocationCounter != nullptr )
+    {
+        stats[ "allocations" ] = Pothos::Object( m_allocations.load( std::memory_order_relaxed ) );
+    }
+    auto latency = latencyToObjectKwargs();
+    if ( !latency.empty() )
+    {
+        stats[ "latency" ] = Pothos::Object( std::move( latency ) );
+    }
+    return stats;
+}
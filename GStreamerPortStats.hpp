@@ -0,0 +1,113 @@
+/// Copyright (c) 2017-2020 Ashley Brighthope
+/// SPDX-License-Identifier: BSL-1.0
+
+#pragma once
+
+#include <Pothos/Framework.hpp>
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
+/**
+ * Counters for the data through one port, updated without locks from the block thread or GStreamer callbacks
+ * and read at any time by the stats probe. Counts are since the last reset().
+ * Latencies are few per buffer and kept under a lock, as the percentiles need the samples.
+ */
+class GStreamerPortStats final
+{
+public:
+    //! Returns the heap allocations made so far by the calling thread
+    using AllocationCounter = uint64_t (*)();
+
+    /**
+     * Plugin registry path a program can add an AllocationCounter at before making blocks, e.g. one counted by its operator new,
+     * to get the allocations made on the buffer path of each port. BenchGStreamer does this to check the minimal metadata mode.
+     */
+    static const char ALLOCATION_COUNTER_PATH[];
+
+    //! Queue occupancy histogram bins, 0% to 100% in 10% steps
+    static constexpr size_t OCCUPANCY_BINS = 11;
+    //! Inter-arrival time histogram bins, bin n counts gaps of 2^(n-1) to 2^n microseconds
+    static constexpr size_t INTER_ARRIVAL_BINS = 32;
+    //! Number of most recent latencies the percentiles are taken over
+    static constexpr size_t LATENCY_WINDOW = 1024;
+
+private:
+    std::atomic< uint64_t > m_buffers;
+    std::atomic< uint64_t > m_bytes;
+    std::atomic< uint64_t > m_drops;
+    std::atomic< uint64_t > m_flowErrors;
+    const AllocationCounter m_allocationCounter;
+    std::atomic< uint64_t > m_allocations;
+    std::atomic< int64_t > m_lastArrivalNs;
+    std::array< std::atomic< uint64_t >, OCCUPANCY_BINS > m_occupancy;
+    std::array< std::atomic< uint64_t >, INTER_ARRIVAL_BINS > m_interArrival;
+    mutable std::mutex m_latencyMutex;
+    std::vector< int64_t > m_latencyWindow;
+    size_t m_latencyNext;
+    uint64_t m_latencyCount;
+    int64_t m_latencyMaxNs;
+
+public:
+    GStreamerPortStats(const GStreamerPortStats&) = delete;
+    GStreamerPortStats& operator=(const GStreamerPortStats&) = delete;
+
+    GStreamerPortStats();
+
+    void reset();
+
+    //! A buffer of the given size went through the port
+    void buffer(size_t bytes);
+    //! A buffer or message was dropped
+    void drop();
+    //! GStreamer returned a flow error for a buffer
+    void flowError();
+    //! Queue occupancy seen when a buffer went through, 1.0 being full
+    void occupancy(double fraction);
+    //! A buffer came out of the pipeline the given time after it went in
+    void latency(int64_t ns);
+
+    /**
+     * @return {"samples", "p50", "p99", "max"} in nanoseconds, percentiles over the last LATENCY_WINDOW buffers, empty if there were none
+     */
+    Pothos::ObjectKwargs latencyToObjectKwargs() const;
+
+    /**
+     * @return {"buffers", "bytes", "drops", "flowErrors", "occupancyHistogram": [OCCUPANCY_BINS counts], "interArrivalHistogram": [INTER_ARRIVAL_BINS counts]},
+     *         "latency": latencyToObjectKwargs() if any buffers were measured, and "allocations" if an allocation counter is registered
+     */
+    Pothos::ObjectKwargs toObjectKwargs() const;
+
+    /**
+     * Adds the heap allocations the calling thread makes while in scope to the "allocations" of the port.
+     * Does nothing when no allocation counter is registered.
+     */
+    class AllocationScope final
+    {
+    private:
+        GStreamerPortStats &m_portStats;
+        const uint64_t m_start;
+
+    public:
+        AllocationScope(const AllocationScope&) = delete;
+        AllocationScope& operator=(const AllocationScope&) = delete;
+
+        explicit AllocationScope(GStreamerPortStats &portStats) noexcept :
+            m_portStats( portStats ),
+            m_start( ( portStats.m_allocationCounter != nullptr ) ? portStats.m_allocationCounter() : 0 )
+        {
+        }
+
+        ~AllocationScope()
+        {
+            if ( m_portStats.m_allocationCounter != nullptr )
+            {
+                m_portStats.m_allocations.fetch_add( m_portStats.m_allocationCounter() - m_start, std::memory_order_relaxed );
+            }
+        }
+    };  // class AllocationScope
+
+};  // class GStreamerPortStats
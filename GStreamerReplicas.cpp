@@ -0,0 +1,456 @@
+/// Copyright (c) 2017-2020 Ashley Brighthope
+/// SPDX-License-Identifier: BSL-1.0
+
+#include "GStreamerReplicas.hpp"
+#include "GStreamer.hpp"
+#include "GStreamerLatencyMeta.hpp"
+#include "GStreamerToPothos.hpp"
+#include "GStreamerTypes.hpp"
+#include "PothosToGStreamer.hpp"
+#include <Pothos/Exception.hpp>
+#include <functional>
+#include <utility>
+
+GStreamerReplicas::GStreamerReplicas(
+    GStreamer *gstreamerBlock,
+    std::vector< std::unique_ptr< GStreamerSubWorker > > ports,
+    const std::string &appSrcName,
+    const std::string &appSinkName
+) :
+    GStreamerSubWorker( gstreamerBlock, appSrcName ),
+    m_ports( std::move( ports ) ),
+    m_appSinkName( appSinkName ),
+    m_pothosInputPort( gstreamerBlock->input( appSrcName ) ),
+    m_pothosOutputPort( gstreamerBlock->output( appSinkName ) ),
+    m_replicas( ),
+    m_key( ),
+    m_nextReplica( 0 ),
+    m_nextInSequence( 0 ),
+    m_nextOutSequence( 0 ),
+    m_reorder( ),
+    m_eosPushed( false ),
+    m_eosPosted( false ),
+    m_outputStats( ),
+    m_sampleCount( 0 ),
+    m_blockPool( std::make_shared< GstTypes::BlockPool >() )
+{
+}
+
+GStreamerReplicas::~GStreamerReplicas()
+{
+    deactivate();
+}
+
+std::string GStreamerReplicas::binName(size_t index)
+{
+    return "replica" + std::to_string( index );
+}
+
+std::vector< std::unique_ptr< GStreamerSubWorker > > GStreamerReplicas::releasePorts()
+{
+    return std::move( m_ports );
+}
+
+void GStreamerReplicas::eos(GstAppSink * /* appSink */, gpointer userData)
+{
+    static_cast< GStreamerReplicas* >( userData )->gstreamerBlock()->notifyWork();
+}
+
+GstFlowReturn GStreamerReplicas::newSample(GstAppSink * /* appSink */, gpointer userData)
+{
+    auto self = static_cast< GStreamerReplicas* >( userData );
+    ++self->m_sampleCount;
+    self->gstreamerBlock()->notifyWork();
+    return GST_FLOW_OK;
+}
+
+void GStreamerReplicas::needData(GstAppSrc * /* appSrc */, guint /* length */, gpointer userData)
+{
+    static_cast< GStreamerReplicas* >( userData )->gstreamerBlock()->notifyWork();
+}
+
+void GStreamerReplicas::activate()
+{
+    const std::string funcName( "GStreamerReplicas::activate" );
+
+    m_key = gstreamerBlock()->replicaKey();
+    m_nextReplica = 0;
+    m_nextInSequence = 0;
+    m_nextOutSequence = 0;
+    m_reorder.clear();
+    m_eosPushed = false;
+    m_eosPosted = false;
+    m_sampleCount = 0;
+
+    auto pipeline = GST_BIN( gstreamerBlock()->getPipeline() );
+    for (size_t index = 0; index < gstreamerBlock()->replicas(); ++index)
+    {
+        const GstTypes::GstElementPtr bin( gst_bin_get_by_name( pipeline, binName( index ).c_str() ) );
+        if ( !bin )
+        {
+            throw Pothos::NullPointerException( funcName, "Could not find the bin of " + binName( index ) );
+        }
+
+        GstTypes::GstElementPtr appSrc( gst_bin_get_by_name( GST_BIN( bin.get() ), name().c_str() ) );
+        GstTypes::GstElementPtr appSink( gst_bin_get_by_name( GST_BIN( bin.get() ), m_appSinkName.c_str() ) );
+        if ( !GST_IS_APP_SRC( appSrc.get() ) || !GST_IS_APP_SINK( appSink.get() ) )
+        {
+            throw Pothos::NullPointerException( funcName,
+                "Could not find a GstAppSrc named \"" + name() + "\" and a GstAppSink named \"" + m_appSinkName + "\" in " + binName( index ) );
+        }
+
+        std::unique_ptr< Replica > replica( new Replica() );
+        replica->appSrc.reset( GST_APP_SRC( appSrc.release() ) );
+        replica->appSink.reset( GST_APP_SINK( appSink.release() ) );
+
+        // Set up as the appsrc of a single pipeline is
+        replica->baseCaps.reset( gst_app_src_get_caps( replica->appSrc.get() ) );
+        PothosToGStreamer::setupStreamAppSrc( gstreamerBlock(), replica->appSrc.get() );
+
+        /* Limit number of buffer to queue (Prevent memory runaway). */
+        gst_app_sink_set_max_buffers( replica->appSink.get(), GStreamerToPothos::MAX_BUFFERS );
+
+        GstAppSinkCallbacks gstAppSinkCallbacks{
+            &GStreamerReplicas::eos,
+            nullptr,
+            &GStreamerReplicas::newSample,
+            { }
+        };
+        gst_app_sink_set_callbacks(
+            replica->appSink.get(),
+            &gstAppSinkCallbacks,
+            this,
+            nullptr
+        );
+
+        // Woken when a full replica has room again
+        GstAppSrcCallbacks gstAppSrcCallbacks{
+            &GStreamerReplicas::needData,
+            nullptr,
+            nullptr,
+            { }
+        };
+        gst_app_src_set_callbacks( replica->appSrc.get(), &gstAppSrcCallbacks, this, nullptr );
+
+        m_replicas.push_back( std::move( replica ) );
+    }
+}
+
+void GStreamerReplicas::deactivate()
+{
+    for (auto &replica : m_replicas)
+    {
+        GstAppSinkCallbacks gstAppSinkCallbacks{
+            nullptr,
+            nullptr,
+            nullptr,
+            { }
+        };
+        gst_app_sink_set_callbacks(
+            replica->appSink.get(),
+            &gstAppSinkCallbacks,
+            nullptr,
+            nullptr
+        );
+
+        GstAppSrcCallbacks gstAppSrcCallbacks{
+            nullptr,
+            nullptr,
+            nullptr,
+            { }
+        };
+        gst_app_src_set_callbacks( replica->appSrc.get(), &gstAppSrcCallbacks, nullptr, nullptr );
+    }
+    m_replicas.clear();
+    m_reorder.clear();
+}
+
+size_t GStreamerReplicas::pickReplica(const Pothos::Packet &packet) const
+{
+    if ( !m_key.empty() )
+    {
+        const auto key_it = packet.metadata.find( m_key );
+        if ( key_it != packet.metadata.end() )
+        {
+            // Packets with the same key always go to the same replica
+            return std::hash< std::string >()( key_it->second.toString() ) % m_replicas.size();
+        }
+    }
+    return m_nextReplica % m_replicas.size();
+}
+
+bool GStreamerReplicas::full(GstAppSrc *appSrc)
+{
+    // A max-bytes of 0 is no limit
+    const auto maxBytes = gst_app_src_get_max_bytes( appSrc );
+    return maxBytes != 0 && gst_app_src_get_current_level_bytes( appSrc ) >= maxBytes;
+}
+
+//! @return true if the next input packet can be pushed
+bool GStreamerReplicas::inputReady() const
+{
+    if ( m_eosPushed || !m_pothosInputPort->hasMessage() )
+    {
+        return false;
+    }
+    const auto message = m_pothosInputPort->peekMessage();
+    if ( message.type() != typeid( Pothos::Packet ) )
+    {
+        return true;
+    }
+    return !full( m_replicas[ pickReplica( message.extract< Pothos::Packet >() ) ]->appSrc.get() );
+}
+
+/**
+ * @brief Push the next input packet into its replica.
+ * @return true if a packet was taken from the input port
+ */
+bool GStreamerReplicas::pushInput()
+{
+    if ( m_eosPushed || !m_pothosInputPort->hasMessage() )
+    {
+        return false;
+    }
+
+    const auto message = m_pothosInputPort->peekMessage();
+    if ( message.type() != typeid( Pothos::Packet ) )
+    {
+        poco_warning( GstTypes::logger(), "Received message on port "+m_pothosInputPort->name()+" of type we can't handle. Only accept Pothos::Packet" );
+        m_pothosInputPort->popMessage();
+        portStats().drop();
+        return true;
+    }
+
+    const auto &packet = message.extract< Pothos::Packet >();
+    auto &replica = *m_replicas[ pickReplica( packet ) ];
+
+    // Hold the packet back while its replica is full, this is what bounds the packets waiting to be put in order
+    auto appSrc = replica.appSrc.get();
+    if ( full( appSrc ) )
+    {
+        return false;
+    }
+
+    auto gstBuffer = GstTypes::makeGstBufferFromPacket( packet, m_blockPool );
+    if ( gstBuffer )
+    {
+        std::string caps;
+        if ( GstTypes::ifKeyExtract( packet.metadata, GstTypes::PACKET_META_CAPS, caps ) )
+        {
+            GstTypes::GstCapsPtr gstCaps( gst_caps_from_string( caps.c_str() ) );
+            if ( gstCaps )
+            {
+                gst_app_src_set_caps( appSrc, gstCaps.get() );
+            }
+        }
+        else
+        {
+            gst_app_src_set_caps( appSrc, replica.baseCaps.get() );
+        }
+
+        if ( gstreamerBlock()->measureLatency() )
+        {
+            GstLatencyMeta::stamp( gstBuffer.get() );
+        }
+
+        const auto bytes = gst_buffer_get_size( gstBuffer.get() );
+        const auto maxBytes = gst_app_src_get_max_bytes( appSrc );
+        if ( maxBytes != 0 )
+        {
+            portStats().occupancy( static_cast< double >( gst_app_src_get_current_level_bytes( appSrc ) ) / static_cast< double >( maxBytes ) );
+        }
+        const auto flowReturn = gst_app_src_push_buffer( appSrc, gstBuffer.release() );
+        if ( flowReturn == GST_FLOW_OK )
+        {
+            replica.inFlight.push_back( m_nextInSequence++ );
+            portStats().buffer( bytes );
+        }
+        else
+        {
+            portStats().flowError();
+            poco_warning( GstTypes::logger(), "GStreamerReplicas::pushInput() flow_return = " + std::to_string( flowReturn ) + " (" + gst_flow_get_name( flowReturn ) + ")" );
+        }
+        ++m_nextReplica;
+    }
+
+    if ( GstTypes::ifKeyExtract< bool >( packet.metadata, GstTypes::PACKET_META_EOS ).value( false ) )
+    {
+        for (auto &eosReplica : m_replicas)
+        {
+            gst_app_src_end_of_stream( eosReplica->appSrc.get() );
+        }
+        m_eosPushed = true;
+    }
+
+    m_pothosInputPort->popMessage();
+    return true;
+}
+
+void GStreamerReplicas::postOutput(Pothos::Packet packet)
+{
+    m_outputStats.buffer( packet.payload.length );
+    packet.metadata[ GstTypes::PACKET_META_EOS ] = Pothos::Object( false );
+    m_pothosOutputPort->postMessage( std::move( packet ) );
+}
+
+void GStreamerReplicas::pullOutputs()
+{
+    bool allEos = true;
+    for (auto &replica : m_replicas)
+    {
+        while ( true )
+        {
+            std::unique_ptr< GstSample, GstTypes::detail::Deleter< GstSample, gst_sample_unref > > gstSample(
+                gst_app_sink_try_pull_sample( replica->appSink.get(), 0 )
+            );
+            if ( !gstSample )
+            {
+                break;
+            }
+            --m_sampleCount;
+
+            auto packet = GstTypes::makePacketFromGstSample( gstSample.get(), &replica->capsCache );
+            if ( replica->capsCache.change() )
+            {
+                GStreamerToPothos::capsToPayloadInfo( gst_sample_get_caps( gstSample.get() ), replica->dtype, replica->rxRateLabel );
+            }
+            if ( !replica->rxRateLabel.id.empty() )
+            {
+                packet.labels.push_back( replica->rxRateLabel );
+            }
+            packet.payload.dtype = replica->dtype;
+            const auto latencyNs = GstLatencyMeta::elapsedNs( gst_sample_get_buffer( gstSample.get() ) );
+            if ( latencyNs.isSpecified() )
+            {
+                packet.metadata[ GstTypes::PACKET_META_LATENCY ] = Pothos::Object( latencyNs.value() );
+                m_outputStats.latency( latencyNs.value() );
+            }
+            if ( replica->inFlight.empty() )
+            {
+                // More output than input, there is nothing to put it in order with
+                postOutput( std::move( packet ) );
+                continue;
+            }
+            // How many are waiting on the slowest replica
+            m_outputStats.occupancy( static_cast< double >( m_reorder.size() ) / static_cast< double >( m_nextInSequence - m_nextOutSequence ) );
+            m_reorder.emplace( replica->inFlight.front(), std::move( packet ) );
+            replica->inFlight.pop_front();
+        }
+
+        allEos = allEos && ( gst_app_sink_is_eos( replica->appSink.get() ) == TRUE );
+    }
+
+    while ( !m_reorder.empty() && m_reorder.begin()->first == m_nextOutSequence )
+    {
+        postOutput( std::move( m_reorder.begin()->second ) );
+        m_reorder.erase( m_reorder.begin() );
+        ++m_nextOutSequence;
+    }
+
+    if ( !allEos || !m_eosPushed || m_eosPosted )
+    {
+        return;
+    }
+
+    // Every replica is done, packets still waiting for one that was dropped on the way will not get it
+    for (auto &reordered : m_reorder)
+    {
+        postOutput( std::move( reordered.second ) );
+    }
+    m_reorder.clear();
+
+    Pothos::Packet packet;
+    packet.payload = Pothos::BufferChunk( 0 );
+    packet.metadata[ GstTypes::PACKET_META_EOS ] = Pothos::Object( true );
+    m_pothosOutputPort->postMessage( packet );
+    m_eosPosted = true;
+}
+
+void GStreamerReplicas::sendEos()
+{
+    if ( m_replicas.empty() )
+    {
+        throw Pothos::NullPointerException( "Not in running state: " + gstreamerBlock()->getPipelineString(), "GStreamerReplicas::sendEos" );
+    }
+    for (auto &replica : m_replicas)
+    {
+        gst_app_src_end_of_stream( replica->appSrc.get() );
+    }
+    // Nothing more goes in, the EOS is passed on once every replica is done
+    m_eosPushed = true;
+    gstreamerBlock()->notifyWork();
+}
+
+guint64 GStreamerReplicas::getCurrentLevelBytes() const
+{
+    if ( m_replicas.empty() )
+    {
+        throw Pothos::NullPointerException( "Not in running state: " + gstreamerBlock()->getPipelineString(), "GStreamerReplicas::getCurrentLevelBytes" );
+    }
+    guint64 levelBytes = 0;
+    for (const auto &replica : m_replicas)
+    {
+        levelBytes += gst_app_src_get_current_level_bytes( replica->appSrc.get() );
+    }
+    return levelBytes;
+}
+
+uint32_t GStreamerReplicas::getCurrentBufferCount() const
+{
+    if ( m_replicas.empty() )
+    {
+        throw Pothos::NullPointerException( "Not in running state: " + gstreamerBlock()->getPipelineString(), "GStreamerReplicas::getCurrentBufferCount" );
+    }
+    return m_sampleCount.load();
+}
+
+void GStreamerReplicas::resetPortStats()
+{
+    GStreamerSubWorker::resetPortStats();
+    m_outputStats.reset();
+}
+
+void GStreamerReplicas::addPortStats(Pothos::ObjectKwargs &stats) const
+{
+    GStreamerSubWorker::addPortStats( stats );
+    stats[ m_appSinkName ] = Pothos::Object( m_outputStats.toObjectKwargs() );
+}
+
+double GStreamerReplicas::occupancy()
+{
+    if ( m_replicas.empty() )
+    {
+        return 0.0;
+    }
+    if ( m_sampleCount != 0 || inputReady() )
+    {
+        return 1.0;
+    }
+    // Waiting for every replica to finish, to pass the EOS on
+    if ( m_eosPushed && !m_eosPosted )
+    {
+        for (const auto &replica : m_replicas)
+        {
+            if ( gst_app_sink_is_eos( replica->appSink.get() ) == FALSE )
+            {
+                return 0.0;
+            }
+        }
+        return 1.0;
+    }
+    return 0.0;
+}
+
+void GStreamerReplicas::work()
+{
+    if ( m_replicas.empty() )
+    {
+        return;
+    }
+
+    pullOutputs();
+
+    while ( pushInput() )
+    {
+    }
+}
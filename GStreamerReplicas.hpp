@@ -0,0 +1,101 @@
+/// Copyright (c) 2017-2020 Ashley Brighthope
+/// SPDX-License-Identifier: BSL-1.0
+
+#pragma once
+
+#include "GStreamerSubWorker.hpp"
+#include "GStreamerTypes.hpp"
+#include <Pothos/Framework.hpp>
+#include <gst/gst.h>
+#include <gst/app/gstappsink.h>
+#include <gst/app/gstappsrc.h>
+#include <atomic>
+#include <cstdint>
+#include <deque>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+/**
+ * Runs N copies of a pipeline description, each in its own bin with one appsrc and one appsink, from a single input and output port.
+ * Input packets are handed out round robin, or by the value of a metadata key, and the output packets are put back in input order,
+ * so elements that do not thread internally, e.g. software encoders, use N cores.
+ * Every input packet must give exactly one output packet, as with independent chunks such as images or segments.
+ */
+class GStreamerReplicas final : public GStreamerSubWorker
+{
+private:
+    struct Replica
+    {
+        std::unique_ptr< GstAppSrc, GstTypes::GstObjectUnrefFunc > appSrc;
+        std::unique_ptr< GstAppSink, GstTypes::GstObjectUnrefFunc > appSink;
+        //! Caps set in the pipeline description, put back for packets without caps
+        GstTypes::GstCapsPtr baseCaps;
+        GstTypes::GstCapsCache capsCache;
+        Pothos::DType dtype;
+        Pothos::Label rxRateLabel;
+        //! Sequence numbers of the packets pushed into this replica, in the order their output is due
+        std::deque< uint64_t > inFlight;
+    };  // struct Replica
+
+    // The appsrc and appsink sub workers of the description, kept for their ports and calls
+    std::vector< std::unique_ptr< GStreamerSubWorker > > m_ports;
+    const std::string m_appSinkName;
+    Pothos::InputPort *m_pothosInputPort;
+    Pothos::OutputPort *m_pothosOutputPort;
+    std::vector< std::unique_ptr< Replica > > m_replicas;
+    std::string m_key;
+    size_t m_nextReplica;
+    uint64_t m_nextInSequence;
+    uint64_t m_nextOutSequence;
+    std::map< uint64_t, Pothos::Packet > m_reorder;
+    bool m_eosPushed;
+    bool m_eosPosted;
+    // The replica set is named after the input port, the base class stats are for it
+    GStreamerPortStats m_outputStats;
+    std::atomic< uint32_t > m_sampleCount;
+    std::shared_ptr< GstTypes::BlockPool > m_blockPool;
+
+    static void eos(GstAppSink *appSink, gpointer userData);
+    static GstFlowReturn newSample(GstAppSink *appSink, gpointer userData);
+    static void needData(GstAppSrc *appSrc, guint length, gpointer userData);
+    size_t pickReplica(const Pothos::Packet &packet) const;
+    static bool full(GstAppSrc *appSrc);
+    bool inputReady() const;
+    bool pushInput();
+    void pullOutputs();
+    void postOutput(Pothos::Packet packet);
+
+public:
+    GStreamerReplicas() = delete;
+    GStreamerReplicas(const GStreamerReplicas&) = delete;
+    GStreamerReplicas& operator=(const GStreamerReplicas&) = delete;
+
+    GStreamerReplicas(
+        GStreamer *gstreamerBlock,
+        std::vector< std::unique_ptr< GStreamerSubWorker > > ports,
+        const std::string &appSrcName,
+        const std::string &appSinkName
+    );
+    ~GStreamerReplicas() override;
+
+    //! Name of the bin holding replica index in the pipeline
+    static std::string binName(size_t index);
+
+    //! Give back the appsrc and appsink sub workers, when going back to a single pipeline
+    std::vector< std::unique_ptr< GStreamerSubWorker > > releasePorts();
+
+    void activate() override;
+    void deactivate() override;
+    double occupancy() override;
+    void resetPortStats() override;
+    void addPortStats(Pothos::ObjectKwargs &stats) const override;
+    void work() override;
+
+    //! The calls of the appsrc and appsink ports, over every replica
+    void sendEos();
+    guint64 getCurrentLevelBytes() const;
+    uint32_t getCurrentBufferCount() const;
+
+};  // class GStreamerReplicas
@@ -3,7 +3,13 @@
 
 #include "GStreamerStatic.hpp"
 #include "GStreamerTypes.hpp"
+#include <Poco/Environment.h>
+#include <Poco/StringTokenizer.h>
 #include <gst/gst.h>
+#include <deque>
+#include <map>
+#include <set>
+#include <thread>
 
 namespace {
 
@@ -11,6 +17,13 @@ namespace {
     {
         GstTypes::GErrorPtr initError;
 
+        std::mutex preloadMutex;
+        std::condition_variable preloadCond;
+        std::deque< std::string > preloadQueue;
+        std::set< std::string > preloaded;
+        bool preloadStop;
+        std::thread preloadThread;
+
         GStreamerStatic(const GStreamerStatic &) = delete;
         GStreamerStatic& operator=(const GStreamerStatic &) = delete;
 
@@ -18,7 +31,13 @@ namespace {
         GStreamerStatic& operator=(GStreamerStatic &&) = delete;
 
         GStreamerStatic() :
-            initError( )
+            initError( ),
+            preloadMutex( ),
+            preloadCond( ),
+            preloadQueue( ),
+            preloaded( ),
+            preloadStop( false ),
+            preloadThread( )
         {
             if ( GstTypes::debug_extra )
             {
@@ -38,6 +57,68 @@ namespace {
             {
                 poco_information( GstTypes::logger(), "GStreamer version: " + GstStatic::getVersion() );
             }
+
+            if ( !initError )
+            {
+                const Poco::StringTokenizer names(
+                    Poco::Environment::get( "POTHOS_GSTREAMER_PRELOAD", "" ),
+                    ",",
+                    Poco::StringTokenizer::TOK_IGNORE_EMPTY | Poco::StringTokenizer::TOK_TRIM
+                );
+                preload( std::vector< std::string >( names.begin(), names.end() ) );
+            }
+        }
+
+        void preload(const std::vector< std::string > &factoryNames)
+        {
+            {
+                std::lock_guard< std::mutex > lock( preloadMutex );
+                for (const auto &factoryName : factoryNames)
+                {
+                    if ( preloaded.insert( factoryName ).second )
+                    {
+                        preloadQueue.push_back( factoryName );
+                    }
+                }
+                if ( preloadQueue.empty() )
+                {
+                    return;
+                }
+                if ( !preloadThread.joinable() )
+                {
+                    preloadThread = std::thread( &GStreamerStatic::preloadWorker, this );
+                }
+            }
+            preloadCond.notify_one();
+        }
+
+        void preloadWorker()
+        {
+            std::unique_lock< std::mutex > lock( preloadMutex );
+            while ( true )
+            {
+                preloadCond.wait( lock, [ this ]() { return preloadStop || !preloadQueue.empty(); } );
+                if ( preloadStop )
+                {
+                    return;
+                }
+                const auto factoryName = preloadQueue.front();
+                preloadQueue.pop_front();
+                lock.unlock();
+
+                std::unique_ptr< GstElementFactory, GstTypes::GstObjectUnrefFunc > factory( gst_element_factory_find( factoryName.c_str() ) );
+                if ( factory )
+                {
+                    // Loads the plugin providing the factory, unref keeps it loaded
+                    std::unique_ptr< GstPluginFeature, GstTypes::GstObjectUnrefFunc > feature( gst_plugin_feature_load( GST_PLUGIN_FEATURE( factory.get() ) ) );
+                    if ( GstTypes::debug_extra )
+                    {
+                        poco_information( GstTypes::logger(), "GStreamerStatic::preloadWorker(): " + factoryName + ( feature ? " loaded" : " failed to load" ) );
+                    }
+                }
+
+                lock.lock();
+            }
         }
 
         ~GStreamerStatic()
@@ -46,6 +127,17 @@ namespace {
             {
                 poco_information(GstTypes::logger(), "GStreamerStatic::~GStreamerStatic() - gst_is_initialized() = " + GstTypes::boolToString( gst_is_initialized() ) );
             }
+
+            if ( preloadThread.joinable() )
+            {
+                {
+                    std::lock_guard< std::mutex > lock( preloadMutex );
+                    preloadStop = true;
+                }
+                preloadCond.notify_one();
+                preloadThread.join();
+            }
+
             // Only deinit GStreamer if it was initialized
             if ( gst_is_initialized() == TRUE )
             {
@@ -56,17 +148,80 @@ namespace {
 
 }  // namespace
 
-static GStreamerStatic gstreamerStatic;
+// Only initialized when first used, so loading the module does not initialize GStreamer
+static GStreamerStatic& gstreamerStatic()
+{
+    static GStreamerStatic instance;
+    return instance;
+}
 
 namespace GstStatic
 {
+    GError* init()
+    {
+        return gstreamerStatic().initError.get();
+    }
+
     GError* getInitError()
     {
-        return gstreamerStatic.initError.get();
+        return init();
+    }
+
+    void preload(const std::vector< std::string > &factoryNames)
+    {
+        auto &instance = gstreamerStatic();
+        if ( !instance.initError )
+        {
+            instance.preload( factoryNames );
+        }
     }
 
     std::string getVersion()
     {
         return GstTypes::gcharToString( GstTypes::GCharPtr( gst_version_string() ).get() ).value();
     }
+
+    ClockDomain::ClockDomain() :
+        m_clock( gst_system_clock_obtain() ),
+        m_baseTime( gst_clock_get_time( m_clock ) )
+    {
+    }
+
+    ClockDomain::~ClockDomain()
+    {
+        gst_object_unref( m_clock );
+    }
+
+    std::shared_ptr< ClockDomain > ClockDomain::acquire(const std::string &name)
+    {
+        static std::mutex mutex;
+        static std::map< std::string, std::weak_ptr< ClockDomain > > domains;
+
+        std::lock_guard< std::mutex > lock( mutex );
+        auto domain = domains[ name ].lock();
+        if ( !domain )
+        {
+            domain.reset( new ClockDomain() );
+            domains[ name ] = domain;
+        }
+        return domain;
+    }
+
+    GstClock* ClockDomain::clock() const
+    {
+        return m_clock;
+    }
+
+    GstClockTime ClockDomain::baseTime() const
+    {
+        return m_baseTime;
+    }
+
+    void ClockDomain::apply(GstPipeline *pipeline) const
+    {
+        gst_pipeline_use_clock( pipeline, m_clock );
+        // Without a start time the pipeline keeps the base time it is given, when going to PLAYING and back
+        gst_element_set_start_time( GST_ELEMENT( pipeline ), GST_CLOCK_TIME_NONE );
+        gst_element_set_base_time( GST_ELEMENT( pipeline ), m_baseTime );
+    }
 }  // namespace GstStatic
@@ -4,10 +4,92 @@
 #pragma once
 
 #include <glib.h>
+#include <gst/gst.h>
+#include <chrono>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
 #include <string>
+#include <vector>
 
 namespace GstStatic
 {
+    /**
+     * @brief Initialize GStreamer, only done on the first call.
+     *        Element factories listed in the POTHOS_GSTREAMER_PRELOAD environment variable (comma separated) are then preloaded.
+     * @return Initialization error, or nullptr on success
+     */
+    GError* init();
     GError* getInitError();
     std::string getVersion();
+
+    /**
+     * @brief Load the plugins of the given element factories on a background thread,
+     *        so creating a pipeline using them does not wait for the plugins to load.
+     *        Factories already preloaded, or unknown, are skipped.
+     */
+    void preload(const std::vector< std::string > &factoryNames);
+
+    /**
+     * Lets a block wait for work in one place, woken by whatever has work for it.
+     * A notify before the wait is not lost, the next wait returns straight away.
+     */
+    class Waker final
+    {
+    private:
+        std::mutex m_mutex;
+        std::condition_variable m_cond;
+        bool m_notified{ false };
+
+    public:
+        void notify()
+        {
+            {
+                std::lock_guard< std::mutex > lock( m_mutex );
+                m_notified = true;
+            }
+            m_cond.notify_one();
+        }
+
+        //! @return true if notified, false on timeout
+        bool wait(std::chrono::nanoseconds timeout)
+        {
+            std::unique_lock< std::mutex > lock( m_mutex );
+            const auto notified = m_cond.wait_for( lock, timeout, [ this ]() { return m_notified; } );
+            m_notified = false;
+            return notified;
+        }
+    };  // class Waker
+
+    /**
+     * Clock and base time shared by every pipeline in the same named domain,
+     * so their running times, and the time stamps of live sources, line up across blocks.
+     * The domain is created by the first block asking for it and lives as long as a block holds it.
+     */
+    class ClockDomain final
+    {
+    private:
+        GstClock *m_clock;
+        GstClockTime m_baseTime;
+
+        ClockDomain();
+
+    public:
+        ClockDomain(const ClockDomain&) = delete;
+        ClockDomain& operator=(const ClockDomain&) = delete;
+
+        ~ClockDomain();
+
+        static std::shared_ptr< ClockDomain > acquire(const std::string &name);
+
+        GstClock* clock() const;
+        GstClockTime baseTime() const;
+
+        /**
+         * Make the pipeline use the domain clock and base time, instead of selecting its own when it starts playing.
+         * The base time is the one of when the domain was created, so this is for live pipelines,
+         * the buffers of a non-live pipeline applied later start from running time zero and are late.
+         */
+        void apply(GstPipeline *pipeline) const;
+    };  // class ClockDomain
 }  // namespace GstStatic
@@ -5,7 +5,9 @@
 
 GStreamerSubWorker::GStreamerSubWorker(GStreamer *gstreamerBlock, const std::string &name) :
     m_gstreamerBlock( gstreamerBlock ),
-    m_name( name )
+    m_name( name ),
+    m_declared( false ),
+    m_portStats( )
 {
 }
 
@@ -26,15 +28,68 @@ std::string GStreamerSubWorker::funcName(const std::string &funcName) const
     return funcName + "_" + name();
 }
 
+/**
+ * @brief Mark this sub worker as declared up front, its element may only appear
+ *        in the pipeline after the pipeline has started, e.g. added by decodebin.
+ */
+void GStreamerSubWorker::setDeclared(bool declared)
+{
+    m_declared = declared;
+}
+
+bool GStreamerSubWorker::declared() const
+{
+    return m_declared;
+}
+
 void GStreamerSubWorker::activate()
 {
 }
 
+/**
+ * @brief Try to bind to the element in the running pipeline.
+ * @return true if bound
+ */
+bool GStreamerSubWorker::bind()
+{
+    return true;
+}
+
 void GStreamerSubWorker::deactivate()
 {
 }
 
-bool GStreamerSubWorker::blocking()
+/**
+ * @brief Used in preroll activation, to know when this sub worker is ready for the pipeline to start playing.
+ */
+bool GStreamerSubWorker::prerolled()
+{
+    return true;
+}
+
+/**
+ * @brief Used when replicating the pipeline, which feeds every copy from the ports of the sub workers in their place.
+ * @return false if the sub worker needs the single pipeline, e.g. a random access appsrc
+ */
+bool GStreamerSubWorker::canReplicate() const
+{
+    return true;
+}
+
+GStreamerPortStats& GStreamerSubWorker::portStats()
+{
+    return m_portStats;
+}
+
+void GStreamerSubWorker::resetPortStats()
+{
+    m_portStats.reset();
+}
+
+/**
+ * @brief Add the stats of the port of this sub worker, under its name.
+ */
+void GStreamerSubWorker::addPortStats(Pothos::ObjectKwargs &stats) const
 {
-    return false;
+    stats[ name() ] = Pothos::Object( m_portStats.toObjectKwargs() );
 }
@@ -3,6 +3,8 @@
 
 #pragma once
 
+#include "GStreamerPortStats.hpp"
+#include <Pothos/Framework.hpp>
 #include <string>
 
 // Forward declare
@@ -13,10 +15,14 @@ class GStreamerSubWorker
 private:
     GStreamer *m_gstreamerBlock;
     const std::string m_name;
+    bool m_declared;
+    GStreamerPortStats m_portStats;
 
 protected:
     GStreamerSubWorker(GStreamer *gstreamerBlock, const std::string &name);
 
+    GStreamerPortStats& portStats();
+
 public:
     GStreamerSubWorker() = delete;
     GStreamerSubWorker(const GStreamerSubWorker&) = delete; // Non construction-copyable
@@ -29,9 +35,21 @@ public:
     GStreamer* gstreamerBlock() const;
     const std::string& name() const;
     std::string funcName(const std::string &funcName) const;
+    void setDeclared(bool declared);
+    bool declared() const;
     virtual void activate();
+    virtual bool bind();
+    virtual bool prerolled();
     virtual void deactivate();
-    virtual bool blocking();
-    virtual void work(long long maxTimeoutNs) = 0;
+    /**
+     * @brief How urgently this sub worker needs its work() called, sub workers are serviced most urgent first.
+     * @return 0 if there is nothing to do, otherwise how full its queue is, 1.0 being full.
+     */
+    virtual double occupancy() = 0;
+    virtual bool canReplicate() const;
+    virtual void resetPortStats();
+    virtual void addPortStats(Pothos::ObjectKwargs &stats) const;
+    //! Does what work there is without blocking, GStreamer::work() does the waiting
+    virtual void work() = 0;
 
 };  // class GStreamerSubWorker
@@ -0,0 +1,99 @@
+/// Copyright (c) 2017-2020 Ashley Brighthope
+/// SPDX-License-Identifier: BSL-1.0
+
+#include "GStreamerThreadPolicy.hpp"
+#include "GStreamerTypes.hpp"
+#include <cerrno>
+#include <cstring>
+#include <string>
+#include <utility>
+
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+GStreamerThreadPolicy::GStreamerThreadPolicy(std::vector< int > cpus, int nice) :
+    m_cpus( std::move( cpus ) ),
+    m_nice( nice ),
+    m_threadCount( 0 )
+{
+}
+
+bool GStreamerThreadPolicy::enabled(const std::vector< int > &cpus, int nice)
+{
+    return !cpus.empty() || nice != 0;
+}
+
+uint64_t GStreamerThreadPolicy::threadCount() const
+{
+    return m_threadCount;
+}
+
+void GStreamerThreadPolicy::handleMessage(GstMessage *message)
+{
+    if ( GST_MESSAGE_TYPE( message ) != GST_MESSAGE_STREAM_STATUS )
+    {
+        return;
+    }
+
+    GstStreamStatusType type;
+    GstElement *owner;
+    gst_message_parse_stream_status( message, &type, &owner );
+    // Posted by the streaming thread itself, once it is running
+    if ( type == GST_STREAM_STATUS_TYPE_ENTER )
+    {
+        applyToCurrentThread();
+    }
+}
+
+void GStreamerThreadPolicy::applyToCurrentThread()
+{
+#ifdef __linux__
+    // Only threads that got all of the settings are counted
+    bool applied = true;
+    if ( !m_cpus.empty() )
+    {
+        cpu_set_t cpuSet;
+        CPU_ZERO( &cpuSet );
+        for (const auto cpu : m_cpus)
+        {
+            if ( cpu < CPU_SETSIZE )
+            {
+                CPU_SET( cpu, &cpuSet );
+            }
+        }
+        const auto error = pthread_setaffinity_np( pthread_self(), sizeof( cpuSet ), &cpuSet );
+        if ( error != 0 )
+        {
+            applied = false;
+            poco_warning( GstTypes::logger(), std::string( "GStreamerThreadPolicy: Could not set the streaming thread CPU affinity: " ) + std::strerror( error ) );
+        }
+    }
+
+    if ( m_nice != 0 )
+    {
+        // On Linux the nice level is per thread
+        const auto threadId = static_cast< id_t >( syscall( SYS_gettid ) );
+        if ( setpriority( PRIO_PROCESS, threadId, m_nice ) != 0 )
+        {
+            applied = false;
+            poco_warning( GstTypes::logger(), std::string( "GStreamerThreadPolicy: Could not set the streaming thread nice level: " ) + std::strerror( errno ) );
+        }
+    }
+
+    if ( applied )
+    {
+        ++m_threadCount;
+    }
+#else
+    static std::atomic_bool warned{ false };
+    if ( !warned.exchange( true ) )
+    {
+        poco_warning( GstTypes::logger(), "GStreamerThreadPolicy: Streaming thread affinity and nice level are only supported on Linux" );
+    }
+#endif
+}
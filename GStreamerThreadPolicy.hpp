@@ -0,0 +1,46 @@
+/// Copyright (c) 2017-2020 Ashley Brighthope
+/// SPDX-License-Identifier: BSL-1.0
+
+#pragma once
+
+#include <gst/gst.h>
+#include <atomic>
+#include <cstdint>
+#include <vector>
+
+/**
+ * CPU affinity and nice level for the streaming threads of a pipeline.
+ * Applied from the bus sync handler of the block when a streaming thread posts its STREAM_STATUS ENTER message,
+ * which it does from the thread itself before it starts streaming.
+ * Only supported on Linux, elsewhere the threads are left as they are.
+ */
+class GStreamerThreadPolicy final
+{
+private:
+    const std::vector< int > m_cpus;
+    const int m_nice;
+    std::atomic< uint64_t > m_threadCount;
+
+    void applyToCurrentThread();
+
+public:
+    GStreamerThreadPolicy() = delete;
+    GStreamerThreadPolicy(const GStreamerThreadPolicy&) = delete;
+    GStreamerThreadPolicy& operator=(const GStreamerThreadPolicy&) = delete;
+
+    /**
+     * @param cpus CPUs the streaming threads may run on, empty to leave the affinity as is
+     * @param nice Nice level for the streaming threads, 0 to leave it as is
+     */
+    GStreamerThreadPolicy(std::vector< int > cpus, int nice);
+
+    //! @return true if there is anything to apply
+    static bool enabled(const std::vector< int > &cpus, int nice);
+
+    //! Apply the policy to the current thread if the message is posted by a streaming thread starting up, call from a bus sync handler
+    void handleMessage(GstMessage *message);
+
+    //! @return Number of streaming threads all of the policy was applied to
+    uint64_t threadCount() const;
+
+};  // class GStreamerThreadPolicy
@@ -3,16 +3,58 @@
 
 #include "GStreamerToPothos.hpp"
 #include "GStreamer.hpp"
+#include "GStreamerLatencyMeta.hpp"
+#include "GStreamerReplicas.hpp"
 #include "GStreamerTypes.hpp"
 #include <gst/app/gstappsink.h>
 #include <gst/audio/audio-info.h>
+#include <algorithm>
+#include <memory>
 #include <string>
+#include <utility>
 
 namespace
 {
+    Pothos::DType gstAudioInfoToDtype(const GstAudioInfo *gstAudioInfo)
+    {
+        if ( GST_AUDIO_INFO_WIDTH( gstAudioInfo ) != GST_AUDIO_INFO_DEPTH( gstAudioInfo ) )
+        {
+            poco_warning(
+                GstTypes::logger(),
+                "GST_AUDIO_INFO_WIDTH( gstAudioInfo ) = " + std::to_string( GST_AUDIO_INFO_WIDTH( gstAudioInfo ) ) + " and " +
+                "GST_AUDIO_INFO_DEPTH( gstAudioInfo ) = " + std::to_string( GST_AUDIO_INFO_DEPTH( gstAudioInfo ) ) + " do not match, this may produce garbel data."
+            );
+        }
+
+        if ( GST_AUDIO_INFO_ENDIANNESS( gstAudioInfo ) != G_BYTE_ORDER )
+        {
+            poco_warning(GstTypes::logger(), "GST_AUDIO_INFO_ENDIANNESS( gstAudioInfo ) does not match machine endianness");
+        }
+
+        std::string format;
+
+        if ( ( gstAudioInfo->finfo->flags & GST_AUDIO_FORMAT_FLAG_COMPLEX ) != 0 )
+        {
+            format = "complex_";
+        }
+
+        if ( GST_AUDIO_INFO_IS_INTEGER( gstAudioInfo ) )
+        {
+            format += ( GST_AUDIO_INFO_IS_SIGNED( gstAudioInfo ) ) ? "int" : "uint";
+        }
+        else if ( GST_AUDIO_INFO_IS_FLOAT( gstAudioInfo ) )
+        {
+            format += "float";
+        }
+
+        format += std::to_string( GST_AUDIO_INFO_WIDTH( gstAudioInfo ) );
+
+        return Pothos::DType( format, GST_AUDIO_INFO_CHANNELS( gstAudioInfo ) );
+    }
 
     class GStreamerToPothosRunState final {
     private:
+        GStreamer *m_gstreamerBlock;
         std::unique_ptr< GstAppSink, GstTypes::GstObjectUnrefFunc > m_gstAppSink;
         std::atomic_uint32_t m_bufferCount;
         Pothos::DType m_dtype;
@@ -20,15 +62,22 @@ namespace
         GstTypes::GstCapsCache m_gstCapsCach;
         bool m_eosChanged;
         bool m_eos;
+        std::atomic_bool m_prerolled;
+        std::shared_ptr< GstTypes::BlockPool > m_blockPool;
 
-        static void callBack_eos(GstAppSink */* appsink */, gpointer /* user_data */)
+        static void callBack_eos(GstAppSink */* appsink */, gpointer user_data)
         {
+            auto self = static_cast< GStreamerToPothosRunState* >(user_data);
+            self->m_prerolled = true;
+            self->m_gstreamerBlock->notifyWork();
         }
 
         static GstFlowReturn callBack_new_preroll(GstAppSink */* appsink */, gpointer user_data)
         {
             auto self = static_cast< GStreamerToPothosRunState* >(user_data);
             self->m_bufferCount++;
+            self->m_prerolled = true;
+            self->m_gstreamerBlock->notifyWork();
             return GST_FLOW_OK;
         }
 
@@ -36,6 +85,7 @@ namespace
         {
             auto self = static_cast< GStreamerToPothosRunState* >(user_data);
             self->m_bufferCount++;
+            self->m_gstreamerBlock->notifyWork();
             return GST_FLOW_OK;
         }
 
@@ -49,68 +99,9 @@ namespace
             return reinterpret_cast< GstAppSink* >( element.release() );
         }
 
-        static Pothos::DType gstAudioInfoToDtype(const GstAudioInfo *gstAudioInfo)
-        {
-            if ( GST_AUDIO_INFO_WIDTH( gstAudioInfo ) != GST_AUDIO_INFO_DEPTH( gstAudioInfo ) )
-            {
-                poco_warning(
-                    GstTypes::logger(),
-                    "GST_AUDIO_INFO_WIDTH( gstAudioInfo ) = " + std::to_string( GST_AUDIO_INFO_WIDTH( gstAudioInfo ) ) + " and " +
-                    "GST_AUDIO_INFO_DEPTH( gstAudioInfo ) = " + std::to_string( GST_AUDIO_INFO_DEPTH( gstAudioInfo ) ) + " do not match, this may produce garbel data."
-                );
-            }
-
-            if ( GST_AUDIO_INFO_ENDIANNESS( gstAudioInfo ) != G_BYTE_ORDER )
-            {
-                poco_warning(GstTypes::logger(), "GST_AUDIO_INFO_ENDIANNESS( gstAudioInfo ) does not match machine endianness");
-            }
-
-            std::string format;
-
-            if ( ( gstAudioInfo->finfo->flags & GST_AUDIO_FORMAT_FLAG_COMPLEX ) != 0 )
-            {
-                format = "complex_";
-            }
-
-            if ( GST_AUDIO_INFO_IS_INTEGER( gstAudioInfo ) )
-            {
-                format += ( GST_AUDIO_INFO_IS_SIGNED( gstAudioInfo ) ) ? "int" : "uint";
-            }
-            else if ( GST_AUDIO_INFO_IS_FLOAT( gstAudioInfo ) )
-            {
-                format += "float";
-            }
-
-            format += std::to_string( GST_AUDIO_INFO_WIDTH( gstAudioInfo ) );
-
-            return Pothos::DType( format, GST_AUDIO_INFO_CHANNELS( gstAudioInfo ) );
-        }
-
         void capsToMetaInfo(GstCaps* caps)
         {
-            if ( caps == nullptr )
-            {
-                m_dtype = Pothos::DType();
-                m_rxRateLabel = Pothos::Label();
-                return;
-            }
-
-            GstAudioInfo gstAudioInfo;
-            if ( gst_audio_info_from_caps(&gstAudioInfo, caps) == TRUE )
-            {
-                if ( gstAudioInfo.layout != GST_AUDIO_LAYOUT_INTERLEAVED )
-                {
-                    poco_warning(GstTypes::logger(), "We do not support non INTERLEAVED data");
-                }
-                //poco_information(GstTypes::logger(), std::string("gstAudioInfo.finfo->name: ") + gstAudioInfo.finfo->name);
-                m_dtype = gstAudioInfoToDtype( &gstAudioInfo );
-                m_rxRateLabel = Pothos::Label("rxRate", Pothos::Object( GST_AUDIO_INFO_RATE( &gstAudioInfo ) ), 0);
-            }
-            else
-            {
-                m_dtype = Pothos::DType();
-                m_rxRateLabel = Pothos::Label();
-            }
+            GStreamerToPothos::capsToPayloadInfo( caps, m_dtype, m_rxRateLabel );
         }
     public:
         GStreamerToPothosRunState() = delete;
@@ -120,15 +111,18 @@ namespace
         GStreamerToPothosRunState& operator=(GStreamerToPothosRunState&&) = delete;
 
         explicit GStreamerToPothosRunState(GStreamerSubWorker *gstreamerSubWorker) :
+            m_gstreamerBlock( gstreamerSubWorker->gstreamerBlock() ),
             m_gstAppSink( getAppSinkByName( gstreamerSubWorker ) ),
             m_bufferCount( 0 ),
             m_dtype(),
             m_rxRateLabel(),
             m_eosChanged( false ),
-            m_eos( false )
+            m_eos( false ),
+            m_prerolled( false ),
+            m_blockPool( std::make_shared< GstTypes::BlockPool >() )
         {
             /* Limit number of buffer to queue (Prevent memory runaway). */
-            gst_app_sink_set_max_buffers(m_gstAppSink.get(), 20);
+            gst_app_sink_set_max_buffers(m_gstAppSink.get(), GStreamerToPothos::MAX_BUFFERS);
 
             GstAppSinkCallbacks gstAppSinkCallbacks{
                 &callBack_eos,
@@ -172,12 +166,30 @@ namespace
             return m_eos;
         }
 
+        bool prerolled() const
+        {
+            return m_prerolled.load();
+        }
+
         uint32_t bufferCount() const
         {
             return m_bufferCount.load();
         }
 
-        GstSample* tryPullSample( GstClockTime timeout )
+        //! @return How full the appsink queue is, 1.0 being full
+        double occupancy() const
+        {
+            const auto bufferCount = m_bufferCount.load();
+            if ( bufferCount != 0 )
+            {
+                return std::min( 1.0, static_cast< double >( bufferCount ) / GStreamerToPothos::MAX_BUFFERS );
+            }
+            // An EOS not yet passed on needs servicing too
+            const auto eos = ( gst_app_sink_is_eos( m_gstAppSink.get() ) == TRUE );
+            return ( eos != m_eos ) ? 1.0 : 0.0;
+        }
+
+        GstSample* tryPullSample()
         {
             const auto currentEos = ( gst_app_sink_is_eos( m_gstAppSink.get() ) == TRUE );
             if (currentEos != m_eos)
@@ -185,14 +197,33 @@ namespace
                 m_eosChanged = true;
                 m_eos = currentEos;
             }
-            GstSample *gstSample = gst_app_sink_try_pull_sample( m_gstAppSink.get(), timeout );
-            if (gstSample != nullptr)
+            GstSample *gstSample = gst_app_sink_try_pull_sample( m_gstAppSink.get(), 0 );
+            // Every pull takes a count. A prerolled buffer is counted by both callbacks but pulled once,
+            // its second count is taken by the pull that then comes back empty, so the block does not keep getting woken for it
+            auto bufferCount = m_bufferCount.load();
+            while ( bufferCount != 0 && !m_bufferCount.compare_exchange_weak( bufferCount, bufferCount - 1 ) )
             {
-                m_bufferCount--;
             }
             return gstSample;
         }
 
+        //! Only the payload, and the caps when they change, with the buffer mapping in a pooled block
+        Pothos::Packet createMinimalPacketFromGstSample(GstSample* gstSample)
+        {
+            Pothos::Packet packet;
+            packet.payload = GstTypes::makePayloadFromGstBuffer( gst_sample_get_buffer( gstSample ), m_blockPool );
+
+            auto caps = gst_sample_get_caps( gstSample );
+            if ( m_gstCapsCach.diff( caps ) )
+            {
+                capsToMetaInfo(caps);
+                packet.metadata[ GstTypes::PACKET_META_CAPS ] = Pothos::Object( m_gstCapsCach.str() );
+            }
+            packet.payload.dtype = m_dtype;
+
+            return packet;
+        }
+
         Pothos::Packet createPacketFromGstSample(GstSample* gstSample)
         {
             // Get GStreamer buffer and create Pothos packet from it
@@ -229,8 +260,8 @@ namespace
         GStreamerToPothosImpl(const GStreamerToPothosImpl&) = delete;             // No copy constructor
         GStreamerToPothosImpl& operator= (const GStreamerToPothosImpl&) = delete; // No assignment operator
 
-        GStreamerToPothosImpl(GStreamer* gstreamerBlock, GstAppSink* gstAppSink) :
-            GStreamerSubWorker( gstreamerBlock, GstTypes::gcharToString( GstTypes::GCharPtr( gst_element_get_name( gstAppSink ) ).get() ).value() ),
+        GStreamerToPothosImpl(GStreamer* gstreamerBlock, const std::string &elementName) :
+            GStreamerSubWorker( gstreamerBlock, elementName ),
             m_pothosOutputPort( gstreamerBlock->setupOutput( name() ) ),  // Allocate Pothos output port for our GStreamer pad
             m_runState()
         {
@@ -249,68 +280,156 @@ namespace
 
         uint32_t getCurrentBufferCount()
         {
+            // Replicated, the port is fed by the replica set
+            if ( auto replicaSet = gstreamerBlock()->replicaSet() )
+            {
+                return replicaSet->getCurrentBufferCount();
+            }
+
             check_run_state_ptr();
             return m_runState->bufferCount();
         }
 
-        bool blocking() override
+        double occupancy() override
         {
-            return true;
+            return ( m_runState ) ? m_runState->occupancy() : 0.0;
+        }
+
+        bool prerolled() override
+        {
+            // Declared appsink that is yet to appear in the pipeline does not hold up the pipeline
+            return ( m_runState ) ? m_runState->prerolled() : declared();
         }
 
         void activate() override
         {
+            // Declared elements may not exist yet, they are bound once added to the pipeline
+            if ( declared() )
+            {
+                bind();
+                return;
+            }
             m_runState.reset( new GStreamerToPothosRunState( this ) );
         }
 
+        bool bind() override
+        {
+            if ( !m_runState && gstreamerBlock()->getPipelineElementByName( name() ) )
+            {
+                m_runState.reset( new GStreamerToPothosRunState( this ) );
+            }
+            return static_cast< bool >( m_runState );
+        }
+
         void deactivate() override
         {
             m_runState.reset();
         }
 
-        void work(long long maxTimeoutNs) override
+        void work() override
         {
-            Pothos::Packet packet;
-
-            std::unique_ptr< GstSample, GstTypes::detail::Deleter< GstSample, gst_sample_unref > > gstSample(
-                m_runState->tryPullSample( maxTimeoutNs * GST_NSECOND )
-            );
-
-            if ( gstSample )
+            if ( !m_runState )
             {
-                packet = m_runState->createPacketFromGstSample( gstSample.get() );
+                return;
             }
-            else
+
+            Pothos::Packet packet;
             {
-                if ( m_runState->eosChanged() == false )
+                // Counted up to handing the packet on, posting it allocates the framework's message container
+                GStreamerPortStats::AllocationScope allocationScope( portStats() );
+
+                std::unique_ptr< GstSample, GstTypes::detail::Deleter< GstSample, gst_sample_unref > > gstSample(
+                    m_runState->tryPullSample()
+                );
+
+                if ( gstSample )
+                {
+                    packet = ( gstreamerBlock()->minimalMetadata() ) ?
+                        m_runState->createMinimalPacketFromGstSample( gstSample.get() ) :
+                        m_runState->createPacketFromGstSample( gstSample.get() );
+                    const auto latencyNs = GstLatencyMeta::elapsedNs( gst_sample_get_buffer( gstSample.get() ) );
+                    if ( latencyNs.isSpecified() )
+                    {
+                        packet.metadata[ GstTypes::PACKET_META_LATENCY ] = Pothos::Object( latencyNs.value() );
+                        portStats().latency( latencyNs.value() );
+                    }
+                    portStats().occupancy( static_cast< double >( m_runState->bufferCount() + 1 ) / GStreamerToPothos::MAX_BUFFERS );
+                    portStats().buffer( packet.payload.length );
+                }
+                else
+                {
+                    if ( m_runState->eosChanged() == false )
+                    {
+                        return;
+                    }
+                }
+
+                // If packet.payload is not valid, create empty one with no size.
+                if ( static_cast< bool >( packet.payload ) == false )
                 {
-                    return;
+                    packet.payload = Pothos::BufferChunk( 0 );
+                }
+                // Minimal packets only say so at the end of the stream
+                if ( !gstreamerBlock()->minimalMetadata() || m_runState->eos() )
+                {
+                    packet.metadata[ GstTypes::PACKET_META_EOS ] = Pothos::Object( m_runState->eos() );
                 }
             }
+            m_pothosOutputPort->postMessage( std::move( packet ) );
 
-            // If packet.payload is not valid, create empty one with no size.
-            if ( static_cast< bool >( packet.payload ) == false )
+            // More samples queued, don't let the block wait for a new one
+            if ( m_runState->bufferCount() != 0 )
             {
-                packet.payload = Pothos::BufferChunk( 0 );
+                gstreamerBlock()->notifyWork();
             }
-            packet.metadata[ GstTypes::PACKET_META_EOS ] = Pothos::Object( m_runState->eos() );
-            m_pothosOutputPort->postMessage( packet );
         }
 
     };  // class GStreamerToPothosImpl
 
 }  // namespace
 
+void GStreamerToPothos::capsToPayloadInfo(GstCaps* caps, Pothos::DType &dtype, Pothos::Label &rxRateLabel)
+{
+    if ( caps == nullptr )
+    {
+        dtype = Pothos::DType();
+        rxRateLabel = Pothos::Label();
+        return;
+    }
+
+    GstAudioInfo gstAudioInfo;
+    if ( gst_audio_info_from_caps(&gstAudioInfo, caps) == TRUE )
+    {
+        if ( gstAudioInfo.layout != GST_AUDIO_LAYOUT_INTERLEAVED )
+        {
+            poco_warning(GstTypes::logger(), "We do not support non INTERLEAVED data");
+        }
+        //poco_information(GstTypes::logger(), std::string("gstAudioInfo.finfo->name: ") + gstAudioInfo.finfo->name);
+        dtype = gstAudioInfoToDtype( &gstAudioInfo );
+        rxRateLabel = Pothos::Label("rxRate", Pothos::Object( GST_AUDIO_INFO_RATE( &gstAudioInfo ) ), 0);
+    }
+    else
+    {
+        dtype = Pothos::DType();
+        rxRateLabel = Pothos::Label();
+    }
+}
+
+std::unique_ptr< GStreamerSubWorker > GStreamerToPothos::make(GStreamer* gstreamerBlock, const std::string &elementName)
+{
+    return std::unique_ptr< GStreamerSubWorker >(
+        new GStreamerToPothosImpl(
+            gstreamerBlock,
+            elementName
+        )
+    );
+}
+
 std::unique_ptr< GStreamerSubWorker > GStreamerToPothos::makeIfType(GStreamer* gstreamerBlock, GstElement* gstElement)
 {
     if ( GST_IS_APP_SINK( gstElement ) )
     {
-        return std::unique_ptr< GStreamerSubWorker >(
-            new GStreamerToPothosImpl(
-                gstreamerBlock,
-                reinterpret_cast< GstAppSink* >( gstElement )
-            )
-        );
+        return make( gstreamerBlock, GstTypes::gcharToString( GstTypes::GCharPtr( gst_element_get_name( gstElement ) ).get() ).value() );
     }
     return nullptr;
 }
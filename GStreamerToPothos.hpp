@@ -4,10 +4,20 @@
 #pragma once
 
 #include "GStreamerSubWorker.hpp"
+#include <Pothos/Framework.hpp>
+#include <gst/gstcaps.h>
 #include <gst/gstelement.h>
 #include <memory>
+#include <string>
 
 namespace GStreamerToPothos
 {
+    //! Samples an appsink queues before the pipeline waits for them to be pulled (Prevent memory runaway)
+    constexpr guint MAX_BUFFERS = 20;
+
+    std::unique_ptr< GStreamerSubWorker > make(GStreamer* gstreamerBlock, const std::string &elementName);
     std::unique_ptr< GStreamerSubWorker > makeIfType(GStreamer* gstreamerBlock, GstElement* gstElement);
+
+    //! The dtype and "rxRate" label of the packets for the caps, from the audio info, or unset if they are not audio
+    void capsToPayloadInfo(GstCaps* caps, Pothos::DType &dtype, Pothos::Label &rxRateLabel);
 }  // namespace GStreamerToPothos
@@ -0,0 +1,427 @@
+/// Copyright (c) 2017-2020 Ashley Brighthope
+/// SPDX-License-Identifier: BSL-1.0
+
+#include "GStreamerTracerStats.hpp"
+#include "GStreamerTypes.hpp"
+#include <Pothos/Exception.hpp>
+#include <algorithm>
+#include <cstdlib>
+#include <memory>
+#include <set>
+#include <thread>
+
+namespace
+{
+    using Collectors = std::vector< GStreamerTracerStats* >;
+
+    //! What a "new-element" record of the stats tracer says about an element
+    struct ElementRecord
+    {
+        guint parentIx;
+        std::string name;
+    };
+
+    struct Registry
+    {
+        // Enabling tracers, and adding and removing the log function
+        std::mutex mutex;
+        std::set< std::string > enabled;
+        bool logFunctionAdded{ false };
+        bool defaultLogFunctionRemoved{ false };
+
+        // Only held to copy or replace the list, records are handed to the collectors without it,
+        // so the streaming threads of different pipelines do not wait on each other
+        std::mutex collectorsMutex;
+        std::shared_ptr< const Collectors > collectors{ std::make_shared< const Collectors >() };
+
+        // Elements by stats tracer index, from its "new-element" records, kept until the log function is removed
+        std::mutex elementsMutex;
+        std::map< guint, ElementRecord > elements;
+    };
+
+    Registry& registry()
+    {
+        static Registry _registry;
+        return _registry;
+    }
+
+    const char TRACER_CATEGORY[]{ "GST_TRACER" };
+
+    bool debugFileSet()
+    {
+        static const bool set = ( std::getenv( "GST_DEBUG_FILE" ) != nullptr );
+        return set;
+    }
+
+    const char* tracerParams(const std::string &tracer)
+    {
+        // Also log the latency of each element, not only of the whole pipeline
+        return ( tracer == "latency" ) ? "flags=pipeline+element" : nullptr;
+    }
+
+    //! Index the stats tracer gives the parent of an element that has none
+    constexpr guint NO_PARENT_IX = G_MAXUINT;
+
+    /**
+     * @return Names of the element and all the bins it is in, from the top one, e.g. "pipeline0/replica1/filter",
+     *         as they can be put together from the "new-element" records
+     */
+    std::string elementFullPath(GstElement *element)
+    {
+        using GstObjectPtr = std::unique_ptr< GstObject, GstTypes::GstObjectUnrefFunc >;
+
+        GstObjectPtr top( GST_OBJECT( gst_object_ref( element ) ) );
+        GstObjectPtr parent( gst_object_get_parent( top.get() ) );
+        while ( parent )
+        {
+            top = std::move( parent );
+            parent.reset( gst_object_get_parent( top.get() ) );
+        }
+        if ( top.get() == GST_OBJECT( element ) )
+        {
+            return GstTypes::elementPath( element );
+        }
+        return GstTypes::gcharToString( GstTypes::GCharPtr( gst_object_get_name( top.get() ) ).get() ).value( "" ) + "/" + GstTypes::elementPath( element );
+    }
+}  // namespace
+
+void GStreamerTracerStats::Timing::add(uint64_t ns)
+{
+    ++count;
+    totalNs += ns;
+    maxNs = std::max( maxNs, ns );
+}
+
+Pothos::ObjectKwargs GStreamerTracerStats::Timing::toObjectKwargs() const
+{
+    Pothos::ObjectKwargs timing;
+    timing[ "count"  ] = Pothos::Object( count );
+    timing[ "meanNs" ] = Pothos::Object( ( count == 0 ) ? uint64_t( 0 ) : totalNs / count );
+    timing[ "maxNs"  ] = Pothos::Object( maxNs );
+    return timing;
+}
+
+GStreamerTracerStats::GStreamerTracerStats() :
+    m_mutex( ),
+    m_elementIds( ),
+    m_elementFullPaths( ),
+    m_elementIxs( ),
+    m_foreignElementIxs( ),
+    m_elements( ),
+    m_pipelineLatency( ),
+    m_averageCpuLoad( 0.0 ),
+    m_currentCpuLoad( 0.0 )
+{
+    auto &reg = registry();
+    std::lock_guard< std::mutex > lock( reg.collectorsMutex );
+    auto collectors = std::make_shared< Collectors >( *reg.collectors );
+    collectors->push_back( this );
+    reg.collectors = std::move( collectors );
+}
+
+GStreamerTracerStats::~GStreamerTracerStats()
+{
+    auto &reg = registry();
+    std::lock_guard< std::mutex > lock( reg.mutex );
+    std::shared_ptr< const Collectors > retired;
+    bool last = false;
+    {
+        std::lock_guard< std::mutex > collectorsLock( reg.collectorsMutex );
+        retired = reg.collectors;
+        auto collectors = std::make_shared< Collectors >( *retired );
+        collectors->erase( std::remove( collectors->begin(), collectors->end(), this ), collectors->end() );
+        last = collectors->empty();
+        reg.collectors = std::move( collectors );
+    }
+    // Records still being handed to the list this collector was in may reach it, until they are done with the list
+    while ( retired.use_count() > 1 )
+    {
+        std::this_thread::yield();
+    }
+
+    // The tracer hooks can not be removed, but without a collector their records are dropped at the category threshold
+    // and the debug log is left as it was
+    if ( last && reg.logFunctionAdded )
+    {
+        if ( reg.defaultLogFunctionRemoved )
+        {
+            gst_debug_add_log_function( &gst_debug_log_default, nullptr, nullptr );
+            reg.defaultLogFunctionRemoved = false;
+        }
+        gst_debug_remove_log_function( &GStreamerTracerStats::logFunction );
+        gst_debug_unset_threshold_for_name( TRACER_CATEGORY );
+        reg.logFunctionAdded = false;
+
+        // Records about elements made from now on are not seen
+        std::lock_guard< std::mutex > elementsLock( reg.elementsMutex );
+        reg.elements.clear();
+    }
+}
+
+const std::vector< std::string >& GStreamerTracerStats::supportedTracers()
+{
+    static const std::vector< std::string > tracers{ "latency", "stats", "rusage" };
+    return tracers;
+}
+
+void GStreamerTracerStats::enable(const std::vector< std::string > &tracers)
+{
+    const std::string funcName( "GStreamerTracerStats::enable" );
+
+    auto &reg = registry();
+    std::lock_guard< std::mutex > lock( reg.mutex );
+    for (const auto &tracer : tracers)
+    {
+        const auto &supported = supportedTracers();
+        if ( std::find( supported.begin(), supported.end(), tracer ) == supported.end() )
+        {
+            throw Pothos::InvalidArgumentException( funcName + "(" + tracer + ")", "Tracer not supported" );
+        }
+        if ( reg.enabled.count( tracer ) != 0 )
+        {
+            continue;
+        }
+
+        std::unique_ptr< GstPluginFeature, GstTypes::GstObjectUnrefFunc > feature(
+            gst_registry_find_feature( gst_registry_get(), tracer.c_str(), GST_TYPE_TRACER_FACTORY )
+        );
+        std::unique_ptr< GstPluginFeature, GstTypes::GstObjectUnrefFunc > loaded(
+            ( feature ) ? gst_plugin_feature_load( feature.get() ) : nullptr
+        );
+        if ( !loaded )
+        {
+            throw Pothos::InvalidArgumentException( funcName + "(" + tracer + ")", "Tracer not installed, it comes with the coretracers plugin" );
+        }
+
+        // Tracers register their hooks when created, and the hooks keep them until GStreamer is deinitialized,
+        // the floating reference is sunk and dropped like gst_tracing_register_hook() callers do
+        const auto type = gst_tracer_factory_get_tracer_type( GST_TRACER_FACTORY( loaded.get() ) );
+        const auto tracerObject = g_object_new( type, "params", tracerParams( tracer ), nullptr );
+        gst_object_ref_sink( tracerObject );
+        gst_object_unref( tracerObject );
+        reg.enabled.insert( tracer );
+        poco_information( GstTypes::logger(), funcName + ": Enabled the " + tracer + " tracer" );
+    }
+
+    if ( !reg.enabled.empty() && !reg.logFunctionAdded )
+    {
+        gst_debug_set_threshold_for_name( TRACER_CATEGORY, GST_LEVEL_TRACE );
+        gst_debug_add_log_function( &GStreamerTracerStats::logFunction, nullptr, nullptr );
+        // The default log function is given the records too, they are passed on to it from ours instead,
+        // unless it writes to a file set with GST_DEBUG_FILE, which we can not pass on to it
+        if ( !debugFileSet() )
+        {
+            reg.defaultLogFunctionRemoved = ( gst_debug_remove_log_function( &gst_debug_log_default ) != 0 );
+        }
+        reg.logFunctionAdded = true;
+    }
+}
+
+void GStreamerTracerStats::logFunction(
+    GstDebugCategory *category,
+    GstDebugLevel level,
+    const gchar *file,
+    const gchar *function,
+    gint line,
+    GObject *object,
+    GstDebugMessage *message,
+    gpointer /* userData */
+)
+{
+    if ( g_strcmp0( gst_debug_category_get_name( category ), TRACER_CATEGORY ) != 0 )
+    {
+        if ( !debugFileSet() )
+        {
+            gst_debug_log_default( category, level, file, function, line, object, message, nullptr );
+        }
+        return;
+    }
+
+    std::unique_ptr< GstStructure, GstTypes::detail::Deleter< GstStructure, gst_structure_free > > record(
+        gst_structure_from_string( gst_debug_message_get( message ), nullptr )
+    );
+    if ( record )
+    {
+        dispatch( record.get() );
+    }
+}
+
+void GStreamerTracerStats::dispatch(const GstStructure *record)
+{
+    auto &reg = registry();
+
+    // Only the stats tracer says which element an index is, and only once
+    if ( gst_structure_has_name( record, "new-element" ) )
+    {
+        guint ix = 0;
+        guint parentIx = NO_PARENT_IX;
+        const auto name = GstTypes::gcharToString( gst_structure_get_string( record, "name" ) );
+        if ( gst_structure_get_uint( record, "ix", &ix ) && name.isSpecified() )
+        {
+            gst_structure_get_uint( record, "parent-ix", &parentIx );
+            std::lock_guard< std::mutex > lock( reg.elementsMutex );
+            reg.elements[ ix ] = ElementRecord{ parentIx, name.value() };
+        }
+        return;
+    }
+
+    std::shared_ptr< const Collectors > collectors;
+    {
+        std::lock_guard< std::mutex > lock( reg.collectorsMutex );
+        collectors = reg.collectors;
+    }
+    for (auto collector : *collectors)
+    {
+        collector->record( record );
+    }
+}
+
+GStreamerTracerStats::ElementStats* GStreamerTracerStats::findElement(const GstStructure *record, const char *idField)
+{
+    const auto id = GstTypes::gcharToString( gst_structure_get_string( record, idField ) );
+    if ( !id.isSpecified() )
+    {
+        return nullptr;
+    }
+    const auto id_it = m_elementIds.find( id.value() );
+    return ( id_it != m_elementIds.end() ) ? &m_elements[ id_it->second ] : nullptr;
+}
+
+GStreamerTracerStats::ElementStats* GStreamerTracerStats::findElementIx(guint ix)
+{
+    if ( m_foreignElementIxs.count( ix ) != 0 )
+    {
+        return nullptr;
+    }
+
+    auto ix_it = m_elementIxs.find( ix );
+    if ( ix_it == m_elementIxs.end() )
+    {
+        // An index not seen yet, put its path together from the element and its parents
+        std::string fullPath;
+        {
+            auto &reg = registry();
+            std::lock_guard< std::mutex > lock( reg.elementsMutex );
+            auto element_it = reg.elements.find( ix );
+            while ( element_it != reg.elements.end() )
+            {
+                fullPath = ( fullPath.empty() ) ? element_it->second.name : element_it->second.name + "/" + fullPath;
+                const auto parentIx = element_it->second.parentIx;
+                if ( parentIx == NO_PARENT_IX )
+                {
+                    break;
+                }
+                element_it = reg.elements.find( parentIx );
+                if ( element_it == reg.elements.end() )
+                {
+                    fullPath.clear();
+                }
+            }
+        }
+
+        const auto path_it = m_elementFullPaths.find( fullPath );
+        if ( fullPath.empty() || path_it == m_elementFullPaths.end() )
+        {
+            m_foreignElementIxs.insert( ix );
+            return nullptr;
+        }
+        ix_it = m_elementIxs.emplace( ix, path_it->second ).first;
+    }
+    return &m_elements[ ix_it->second ];
+}
+
+void GStreamerTracerStats::record(const GstStructure *record)
+{
+    std::lock_guard< std::mutex > lock( m_mutex );
+
+    guint64 timeNs = 0;
+    guint value = 0;
+    if ( gst_structure_has_name( record, "element-latency" ) )
+    {
+        auto element = findElement( record, "element-id" );
+        if ( element != nullptr && gst_structure_get_uint64( record, "time", &timeNs ) )
+        {
+            element->latency.add( timeNs );
+        }
+    }
+    else if ( gst_structure_has_name( record, "latency" ) )
+    {
+        if ( findElement( record, "sink-element-id" ) != nullptr && gst_structure_get_uint64( record, "time", &timeNs ) )
+        {
+            m_pipelineLatency.add( timeNs );
+        }
+    }
+    else if ( gst_structure_has_name( record, "buffer" ) )
+    {
+        auto element = ( gst_structure_get_uint( record, "element-ix", &value ) ) ? findElementIx( value ) : nullptr;
+        if ( element != nullptr )
+        {
+            ++element->buffers;
+            if ( gst_structure_get_uint( record, "buffer-size", &value ) )
+            {
+                element->bytes += value;
+            }
+        }
+    }
+    else if ( gst_structure_has_name( record, "proc-rusage" ) )
+    {
+        // In per mille
+        if ( gst_structure_get_uint( record, "average-cpuload", &value ) )
+        {
+            m_averageCpuLoad = value / 10.0;
+        }
+        if ( gst_structure_get_uint( record, "current-cpuload", &value ) )
+        {
+            m_currentCpuLoad = value / 10.0;
+        }
+    }
+}
+
+void GStreamerTracerStats::reset()
+{
+    std::lock_guard< std::mutex > lock( m_mutex );
+    m_elementIds.clear();
+    m_elementFullPaths.clear();
+    m_elementIxs.clear();
+    m_foreignElementIxs.clear();
+    m_elements.clear();
+    m_pipelineLatency = Timing();
+    m_averageCpuLoad = 0.0;
+    m_currentCpuLoad = 0.0;
+}
+
+void GStreamerTracerStats::addElement(GstElement *element)
+{
+    const GstTypes::GCharPtr id( g_strdup_printf( "%p", static_cast< void* >( element ) ) );
+    const auto path = GstTypes::elementPath( element );
+    const auto fullPath = elementFullPath( element );
+
+    std::lock_guard< std::mutex > lock( m_mutex );
+    m_elementIds[ id.get() ] = path;
+    m_elementFullPaths[ fullPath ] = path;
+    m_elements[ path ];
+    // An index seen before may be this element's
+    m_foreignElementIxs.clear();
+}
+
+Pothos::ObjectKwargs GStreamerTracerStats::toObjectKwargs() const
+{
+    std::lock_guard< std::mutex > lock( m_mutex );
+
+    Pothos::ObjectKwargs elements;
+    for (const auto &element : m_elements)
+    {
+        Pothos::ObjectKwargs elementStats;
+        elementStats[ "latency" ] = Pothos::Object( element.second.latency.toObjectKwargs() );
+        elementStats[ "buffers" ] = Pothos::Object( element.second.buffers );
+        elementStats[ "bytes"   ] = Pothos::Object( element.second.bytes );
+        elements[ element.first ] = Pothos::Object( elementStats );
+    }
+
+    Pothos::ObjectKwargs stats;
+    stats[ "elements"        ] = Pothos::Object( elements );
+    stats[ "pipelineLatency" ] = Pothos::Object( m_pipelineLatency.toObjectKwargs() );
+    stats[ "averageCpuLoad"  ] = Pothos::Object( m_averageCpuLoad );
+    stats[ "currentCpuLoad"  ] = Pothos::Object( m_currentCpuLoad );
+    return stats;
+}
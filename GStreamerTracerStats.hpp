@@ -0,0 +1,105 @@
+/// Copyright (c) 2017-2020 Ashley Brighthope
+/// SPDX-License-Identifier: BSL-1.0
+
+#pragma once
+
+#include <gst/gst.h>
+#include "GStreamerTypes.hpp"
+#include <Pothos/Framework.hpp>
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <set>
+#include <string>
+#include <vector>
+
+/**
+ * Collects the records of the GStreamer latency, stats and rusage tracers for the elements of one pipeline.
+ * Tracers are process wide and once enabled stay enabled, their records are taken from the GST_TRACER debug category
+ * instead of the debug log while a collector exists, and handed to every collector. A collector keeps the records
+ * about its own elements, and the process wide ones (CPU load). Elements are named by their path from the pipeline,
+ * e.g. "replica1/filter", so elements with the same name in different bins or pipelines are kept apart.
+ * The stats tracer names the element of a record by an index, which its "new-element" record gives the name and parent of.
+ * It logs that record once, when it first sees the element, so an element it saw before it was in a bin, e.g. one made
+ * after the tracer was enabled, has no parent and can not be told apart from elements of other pipelines. It is left out.
+ */
+class GStreamerTracerStats final
+{
+private:
+    struct Timing
+    {
+        uint64_t count{ 0 };
+        uint64_t totalNs{ 0 };
+        uint64_t maxNs{ 0 };
+
+        void add(uint64_t ns);
+        Pothos::ObjectKwargs toObjectKwargs() const;
+    };
+
+    struct ElementStats
+    {
+        Timing latency;
+        uint64_t buffers{ 0 };
+        uint64_t bytes{ 0 };
+    };
+
+    mutable std::mutex m_mutex;
+    // Element pointer as printed by the latency tracer, to element path
+    std::map< std::string, std::string > m_elementIds;
+    // Element path from the top bin, as put together from the stats tracer records, to element path
+    std::map< std::string, std::string > m_elementFullPaths;
+    // Element index of the stats tracer, to element path
+    std::map< guint, std::string > m_elementIxs;
+    // Element indexes of the stats tracer that are not ours
+    std::set< guint > m_foreignElementIxs;
+    std::map< std::string, ElementStats > m_elements;
+    Timing m_pipelineLatency;
+    double m_averageCpuLoad;
+    double m_currentCpuLoad;
+
+    static void logFunction(
+        GstDebugCategory *category,
+        GstDebugLevel level,
+        const gchar *file,
+        const gchar *function,
+        gint line,
+        GObject *object,
+        GstDebugMessage *message,
+        gpointer userData
+    );
+    static void dispatch(const GstStructure *record);
+    void record(const GstStructure *record);
+    ElementStats* findElement(const GstStructure *record, const char *idField);
+    ElementStats* findElementIx(guint ix);
+
+public:
+    GStreamerTracerStats(const GStreamerTracerStats&) = delete;
+    GStreamerTracerStats& operator=(const GStreamerTracerStats&) = delete;
+
+    GStreamerTracerStats();
+    ~GStreamerTracerStats();
+
+    //! @return Tracers that can be enabled
+    static const std::vector< std::string >& supportedTracers();
+
+    /**
+     * Enable the given tracers for the whole process, tracers already enabled are skipped.
+     * Their records are dropped again at the GST_TRACER debug category when the last collector is destroyed.
+     * @throws Pothos::InvalidArgumentException for a tracer that is not supported or not installed
+     */
+    static void enable(const std::vector< std::string > &tracers);
+
+    //! Forget the elements and records, for a new pipeline
+    void reset();
+
+    //! Keep the records about this element, it is referenced until reset()
+    void addElement(GstElement *element);
+
+    /**
+     * @return {"elements": {path: {"latency": {"count", "meanNs", "maxNs"}, "buffers", "bytes"}},
+     *          "pipelineLatency": {"count", "meanNs", "maxNs"},
+     *          "averageCpuLoad", "currentCpuLoad" in percent of the process}
+     */
+    Pothos::ObjectKwargs toObjectKwargs() const;
+
+};  // class GStreamerTracerStats
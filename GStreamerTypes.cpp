@@ -6,6 +6,7 @@
 #include <Pothos/Exception.hpp>
 #include <Pothos/Framework.hpp>
 #include <gst/gst.h>
+#include <new>
 #include <string>
 #include <utility>
 
@@ -40,6 +41,8 @@ namespace GstTypes
     const char PACKET_META_OFFSET    []{ "offset"     };
     const char PACKET_META_OFFSET_END[]{ "offset_end" };
 
+    const char PACKET_META_LATENCY   []{ "latency"    };
+
     Poco::Logger & logger()
     {
         static auto &_logger = Poco::Logger::get("GStreamer");
@@ -95,6 +98,25 @@ namespace GstTypes
         return std::string( gstr );
     }
 
+    std::string elementPath(GstElement *element)
+    {
+        using GstObjectPtr = std::unique_ptr< GstObject, GstObjectUnrefFunc >;
+
+        std::string path = gcharToString( GCharPtr( gst_element_get_name( element ) ).get() ).value( "" );
+        GstObjectPtr parent( gst_object_get_parent( GST_OBJECT( element ) ) );
+        while ( parent )
+        {
+            GstObjectPtr grandParent( gst_object_get_parent( parent.get() ) );
+            if ( !grandParent )
+            {
+                break;
+            }
+            path = gcharToString( GCharPtr( gst_object_get_name( parent.get() ) ).get() ).value( "" ) + "/" + path;
+            parent = std::move( grandParent );
+        }
+        return path;
+    }
+
     Pothos::Object gcharToObject(const gchar *gstr)
     {
         if ( gstr == nullptr )
@@ -104,6 +126,11 @@ namespace GstTypes
         return Pothos::Object( gstr );
     }
 
+    Pothos::Object gstClockTimeToObject(GstClockTime gstClockTime)
+    {
+        return (gstClockTime == GST_CLOCK_TIME_NONE) ? Pothos::Object() : Pothos::Object(gstClockTime);
+    }
+
 //-----------------------------------------------------------------------------
     namespace
     {
@@ -182,25 +209,9 @@ namespace GstTypes
             );
     }
 
-    GstBufferPtr makeGstBufferFromPacket(const Pothos::Packet& packet)
+    //! Copy the time stamps, offsets and flags in the packet meta data to the buffer
+    static void packetMetadataToGstBuffer(const Pothos::Packet& packet, GstBuffer *gstBufferPtr)
     {
-        const std::string funcName( "GstTypes::makeGstBufferFromPacket()" );
-        //poco_information( GstTypes::logger(), funcName + " packet.payload.length = " + std::to_string( packet.payload.length ) );
-
-        // Make a copy of the Pothos buffer for GStreamer buffer wrapping.
-        // When GStreamer buffer is freed, it will free the copy of Pothos::BufferChunk.
-        auto bufferChunk = std::make_shared< Pothos::BufferChunk >(packet.payload);
-
-        auto gstBuffer = makeSharedGstBuffer( bufferChunk->as< void* >(), bufferChunk->length, bufferChunk );
-
-        if ( !gstBuffer )
-        {
-            // Could not allocate buffer.... bail
-            poco_error( GstTypes::logger(), funcName + " Could not alloc buffer of size = " + std::to_string( packet.payload.length ) );
-            return {};
-        }
-
-        auto * const gstBufferPtr = gstBuffer.get();
         ifKeyExtract( packet.metadata, PACKET_META_PTS       , GST_BUFFER_PTS       ( gstBufferPtr ) );
         ifKeyExtract( packet.metadata, PACKET_META_DTS       , GST_BUFFER_DTS       ( gstBufferPtr ) );
         ifKeyExtract( packet.metadata, PACKET_META_DURATION  , GST_BUFFER_DURATION  ( gstBufferPtr ) );
@@ -215,7 +226,7 @@ namespace GstTypes
             const auto & flags_args = meta_flags_args_result.value();
             if ( GstTypes::debug_extra )
             {
-                poco_information( GstTypes::logger(), funcName + " We got GST_BUFFER_META_FLAGS in the metadata: " + Pothos::Object( flags_args ).toString() );
+                poco_information( GstTypes::logger(), "GstTypes::makeGstBufferFromPacket() We got GST_BUFFER_META_FLAGS in the metadata: " + Pothos::Object( flags_args ).toString() );
             }
 
             for (const auto &flag : GST_BUFFER_FLAG_LIST)
@@ -232,6 +243,77 @@ namespace GstTypes
                 }
             }
         }
+    }
+
+    GstBufferPtr makeGstBufferFromPacket(const Pothos::Packet& packet)
+    {
+        static const std::string funcName( "GstTypes::makeGstBufferFromPacket()" );
+        //poco_information( GstTypes::logger(), funcName + " packet.payload.length = " + std::to_string( packet.payload.length ) );
+
+        // Make a copy of the Pothos buffer for GStreamer buffer wrapping.
+        // When GStreamer buffer is freed, it will free the copy of Pothos::BufferChunk.
+        auto bufferChunk = std::make_shared< Pothos::BufferChunk >(packet.payload);
+
+        auto gstBuffer = makeSharedGstBuffer( bufferChunk->as< void* >(), bufferChunk->length, bufferChunk );
+
+        if ( !gstBuffer )
+        {
+            // Could not allocate buffer.... bail
+            poco_error( GstTypes::logger(), funcName + " Could not alloc buffer of size = " + std::to_string( packet.payload.length ) );
+            return {};
+        }
+
+        packetMetadataToGstBuffer( packet, gstBuffer.get() );
+
+        return gstBuffer;
+    }
+
+    namespace
+    {
+        //! Copy of the Pothos buffer a GstBuffer wraps, in a block from the pool it goes back to
+        struct PooledBufferChunk
+        {
+            Pothos::BufferChunk bufferChunk;
+            std::shared_ptr< BlockPool > pool;
+        };
+
+        void gDestroyNotifyPooledBufferChunk(gpointer data)
+        {
+            auto *pooled = static_cast< PooledBufferChunk* >( data );
+            // Keep the pool until the block is back in it
+            const auto pool = std::move( pooled->pool );
+            pooled->~PooledBufferChunk();
+            pool->deallocate( pooled, sizeof( PooledBufferChunk ) );
+        }
+    }  // namespace
+
+    GstBufferPtr makeGstBufferFromPacket(const Pothos::Packet& packet, const std::shared_ptr< BlockPool > &pool)
+    {
+        static const std::string funcName( "GstTypes::makeGstBufferFromPacket()" );
+
+        auto *pooled = new ( pool->allocate( sizeof( PooledBufferChunk ) ) ) PooledBufferChunk{ packet.payload, pool };
+        const auto size = pooled->bufferChunk.length;
+
+        GstBufferPtr gstBuffer(
+            gst_buffer_new_wrapped_full(
+                /*flags    =*/ GST_MEMORY_FLAG_READONLY,
+                /*data     =*/ pooled->bufferChunk.as< void* >(),
+                /*maxsize  =*/ size,
+                /*offset   =*/ 0,
+                /*size     =*/ size,
+                /*user_data=*/ pooled,
+                /*notify   =*/ &gDestroyNotifyPooledBufferChunk
+            )
+        );
+
+        if ( !gstBuffer )
+        {
+            // Could not allocate buffer.... bail
+            poco_error( GstTypes::logger(), funcName + " Could not alloc buffer of size = " + std::to_string( packet.payload.length ) );
+            return {};
+        }
+
+        packetMetadataToGstBuffer( packet, gstBuffer.get() );
 
         return gstBuffer;
     }
@@ -270,8 +352,16 @@ namespace GstTypes
 
             static Pothos::SharedBuffer makeSharedReadBuffer(GstBuffer *gstBuffer)
             {
-                auto gstBufferMap = std::make_shared< GstBufferMap >( gstBuffer, GST_MAP_READ );
+                return makeSharedReadBuffer( std::make_shared< GstBufferMap >( gstBuffer, GST_MAP_READ ) );
+            }
+
+            static Pothos::SharedBuffer makeSharedReadBuffer(GstBuffer *gstBuffer, const std::shared_ptr< BlockPool > &pool)
+            {
+                return makeSharedReadBuffer( std::allocate_shared< GstBufferMap >( BlockPoolAllocator< GstBufferMap >( pool ), gstBuffer, GST_MAP_READ ) );
+            }
 
+            static Pothos::SharedBuffer makeSharedReadBuffer(const std::shared_ptr< GstBufferMap > &gstBufferMap)
+            {
                 return
                     Pothos::SharedBuffer(
                         reinterpret_cast< size_t >( gstBufferMap->m_mapInfo.data ),
@@ -283,6 +373,55 @@ namespace GstTypes
         };  // class GstBufferMap
     }  // namespace
 
+    BlockPool::~BlockPool()
+    {
+        for (auto &bySize : m_free)
+        {
+            for (auto *block : bySize.second)
+            {
+                ::operator delete( block );
+            }
+        }
+    }
+
+    void* BlockPool::allocate(size_t size)
+    {
+        {
+            std::lock_guard< std::mutex > lock( m_mutex );
+            for (auto &bySize : m_free)
+            {
+                if ( bySize.first == size && !bySize.second.empty() )
+                {
+                    auto *block = bySize.second.back();
+                    bySize.second.pop_back();
+                    return block;
+                }
+            }
+        }
+        return ::operator new( size );
+    }
+
+    void BlockPool::deallocate(void *block, size_t size) noexcept
+    {
+        std::lock_guard< std::mutex > lock( m_mutex );
+        try
+        {
+            for (auto &bySize : m_free)
+            {
+                if ( bySize.first == size )
+                {
+                    bySize.second.push_back( block );
+                    return;
+                }
+            }
+            m_free.emplace_back( size, std::vector< void* >{ block } );
+        }
+        catch (const std::bad_alloc &)
+        {
+            ::operator delete( block );
+        }
+    }
+
 //-----------------------------------------------------------------------------
 
     class GstCapsCache::Impl final
@@ -397,6 +536,11 @@ namespace GstTypes
         return packet;
     }
 
+    Pothos::BufferChunk makePayloadFromGstBuffer(GstBuffer *gstBuffer, const std::shared_ptr< BlockPool > &pool)
+    {
+        return Pothos::BufferChunk( GstBufferMap::makeSharedReadBuffer( gstBuffer, pool ) );
+    }
+
     Pothos::Packet makePacketFromGstBuffer(GstBuffer *gstBuffer)
     {
         Pothos::Packet packet;
@@ -715,6 +859,91 @@ namespace GstTypes
         return miscData;
     }
 
+    void objectToGValue(const Pothos::Object &object, GValue *gvalue)
+    {
+        const std::string funcName( "GstTypes::objectToGValue" );
+        const auto type = G_VALUE_TYPE( gvalue );
+
+        // Enums and flags as returned by gvalueToObject
+        if ( object.type() == typeid( Pothos::ObjectKwargs ) )
+        {
+            const auto &args = object.extract< Pothos::ObjectKwargs >();
+            const auto value_it = args.find( "value" );
+            if ( value_it != args.cend() )
+            {
+                objectToGValue( value_it->second, gvalue );
+                return;
+            }
+        }
+
+        // Strings are parsed the way gst-launch does, e.g. enum nicks, flags "a+b" or caps
+        if ( object.type() == typeid( std::string ) && G_TYPE_FUNDAMENTAL( type ) != G_TYPE_STRING )
+        {
+            if ( gst_value_deserialize( gvalue, object.extract< std::string >().c_str() ) == TRUE )
+            {
+                return;
+            }
+            throw Pothos::InvalidArgumentException( funcName, "Can not parse \"" + object.extract< std::string >() + "\" as " + g_type_name( type ) );
+        }
+
+        try
+        {
+            switch ( G_TYPE_FUNDAMENTAL( type ) )
+            {
+                case G_TYPE_BOOLEAN:
+                    g_value_set_boolean( gvalue, object.convert< bool >() ? TRUE : FALSE );
+                    return;
+                case G_TYPE_INT64:
+                    g_value_set_int64( gvalue, object.convert< gint64 >() );
+                    return;
+                case G_TYPE_UINT64:
+                    g_value_set_uint64( gvalue, object.convert< guint64 >() );
+                    return;
+                case G_TYPE_INT:
+                    g_value_set_int( gvalue, object.convert< gint >() );
+                    return;
+                case G_TYPE_UINT:
+                    g_value_set_uint( gvalue, object.convert< guint >() );
+                    return;
+                case G_TYPE_LONG:
+                    g_value_set_long( gvalue, object.convert< glong >() );
+                    return;
+                case G_TYPE_ULONG:
+                    g_value_set_ulong( gvalue, object.convert< gulong >() );
+                    return;
+                case G_TYPE_FLOAT:
+                    g_value_set_float( gvalue, object.convert< gfloat >() );
+                    return;
+                case G_TYPE_DOUBLE:
+                    g_value_set_double( gvalue, object.convert< gdouble >() );
+                    return;
+                case G_TYPE_STRING:
+                    g_value_set_string( gvalue, ( object.type() == typeid( std::string ) ) ? object.extract< std::string >().c_str() : object.toString().c_str() );
+                    return;
+                case G_TYPE_CHAR:
+                    g_value_set_schar( gvalue, object.convert< gint8 >() );
+                    return;
+                case G_TYPE_UCHAR:
+                    g_value_set_uchar( gvalue, object.convert< guchar >() );
+                    return;
+                case G_TYPE_ENUM:
+                    g_value_set_enum( gvalue, object.convert< gint >() );
+                    return;
+                case G_TYPE_FLAGS:
+                    g_value_set_flags( gvalue, object.convert< guint >() );
+                    return;
+                default:
+                    break;
+            }
+        }
+        catch (const Pothos::Exception &e)
+        {
+            throw Pothos::InvalidArgumentException( funcName, "Can not convert (" + object.getTypeString() + ") to " + g_type_name( type ) + ": " + e.message() );
+        }
+
+        throw Pothos::InvalidArgumentException( funcName, "Can not convert (" + object.getTypeString() + ") to " + g_type_name( type ) );
+    }
+
     static void convert_tag( const GstTagList *list, const gchar *tag, gpointer user_data )
     {
         auto tagMap = static_cast< Pothos::ObjectKwargs* >( user_data );
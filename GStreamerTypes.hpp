@@ -10,6 +10,10 @@
 #include <Poco/Optional.h>
 #include <string>
 #include <array>
+#include <memory>
+#include <mutex>
+#include <utility>
+#include <vector>
 #include <numeric>
 
 namespace GstTypes
@@ -32,6 +36,9 @@ namespace GstTypes
     extern const char PACKET_META_OFFSET[];
     extern const char PACKET_META_OFFSET_END[];
 
+    //! Nanoseconds from the appsrc push to the appsink, when latency is measured
+    extern const char PACKET_META_LATENCY[];
+
     constexpr bool debug_extra = false;
 
     Poco::Logger &logger();
@@ -119,6 +126,11 @@ namespace GstTypes
 
     Pothos::Object gcharToObject(const gchar *gstr);
 
+    //! @return Names of the element and the bins it is in, below the pipeline, e.g. "replica1/filter"
+    std::string elementPath(GstElement *element);
+
+    Pothos::Object gstClockTimeToObject(GstClockTime gstClockTime);
+
     /**
      * @brief Convert GStreamer structure into Pothos::Object
      * @param gstStructure GstStructure to be converted to Pothos::ObjectKwargs.
@@ -147,6 +159,70 @@ namespace GstTypes
         static std::string update(GstCaps* caps, GstCapsCache* gstCapsCache);
     };  // class GstCapsCache
 
+    /**
+     * Blocks of memory recycled instead of freed, so what is allocated for each buffer only comes from the heap until the stream is going.
+     * Blocks can be given back from any thread, the pool lives on until the last block allocated from it is given back.
+     */
+    class BlockPool final
+    {
+    private:
+        std::mutex m_mutex;
+        // Free blocks by size, there are only ever a few sizes
+        std::vector< std::pair< size_t, std::vector< void* > > > m_free;
+
+    public:
+        BlockPool(const BlockPool&) = delete;
+        BlockPool& operator=(const BlockPool&) = delete;
+
+        BlockPool() = default;
+        ~BlockPool();
+
+        void* allocate(size_t size);
+        void deallocate(void *block, size_t size) noexcept;
+    };  // class BlockPool
+
+    //! Allocator from a BlockPool, e.g. for std::allocate_shared
+    template< typename T >
+    struct BlockPoolAllocator
+    {
+        using value_type = T;
+
+        std::shared_ptr< BlockPool > pool;
+
+        explicit BlockPoolAllocator(std::shared_ptr< BlockPool > blockPool) noexcept :
+            pool( std::move( blockPool ) )
+        {
+        }
+
+        template< typename U >
+        BlockPoolAllocator(const BlockPoolAllocator< U > &other) noexcept :
+            pool( other.pool )
+        {
+        }
+
+        T* allocate(size_t n)
+        {
+            return static_cast< T* >( pool->allocate( n * sizeof( T ) ) );
+        }
+
+        void deallocate(T *p, size_t n) noexcept
+        {
+            pool->deallocate( p, n * sizeof( T ) );
+        }
+
+        template< typename U >
+        bool operator==(const BlockPoolAllocator< U > &other) const noexcept
+        {
+            return pool == other.pool;
+        }
+
+        template< typename U >
+        bool operator!=(const BlockPoolAllocator< U > &other) const noexcept
+        {
+            return pool != other.pool;
+        }
+    };  // struct BlockPoolAllocator
+
     Pothos::Packet makePacketFromGstSample(GstSample* gstSample, GstCapsCache* gstCapsCach);
 
     GstBufferPtr makeSharedGstBuffer(const void *data, size_t size, std::shared_ptr< void > container);
@@ -158,6 +234,12 @@ namespace GstTypes
      */
     GstBufferPtr makeGstBufferFromPacket(const Pothos::Packet& packet);
 
+    /**
+     * @brief Like makeGstBufferFromPacket(), with what is allocated to hold on to the payload taken from a pool,
+     *        so it makes no C++ heap allocations once the pool is warmed up, GLib still allocates the GstBuffer and GstMemory.
+     */
+    GstBufferPtr makeGstBufferFromPacket(const Pothos::Packet& packet, const std::shared_ptr< BlockPool > &pool);
+
     /**
      * @brief Create Pothos::Packet from GstBuffer, using shared memory
      * @param gstBuffer GStreamer buffer to make packet from
@@ -165,6 +247,12 @@ namespace GstTypes
      */
     Pothos::Packet makePacketFromGstBuffer(GstBuffer *gstBuffer);
 
+    /**
+     * @brief Map a GstBuffer as a Pothos payload, using shared memory, without any meta data.
+     *        What is allocated to hold on to the GstBuffer is taken from the pool.
+     */
+    Pothos::BufferChunk makePayloadFromGstBuffer(GstBuffer *gstBuffer, const std::shared_ptr< BlockPool > &pool);
+
     Pothos::ObjectKwargs gstSegmentToObjectKwargs(const GstSegment *segment);
 
     Pothos::ObjectKwargs gvalueToObjectKwargs(const GValue* value);
@@ -173,6 +261,15 @@ namespace GstTypes
 
     Pothos::Object gvalueToObject(const GValue *gvalue);
 
+    /**
+     * @brief Convert Pothos::Object into a GValue
+     * @param object Number, bool, string or an enum/flags object from gvalueToObject.
+     *               Strings are deserialized for non string types, e.g. enum nicks or caps.
+     * @param gvalue GValue initialized to the type to convert to
+     * @throws Pothos::InvalidArgumentException if the object can not be converted
+     */
+    void objectToGValue(const Pothos::Object &object, GValue *gvalue);
+
     Pothos::ObjectKwargs gstTagListToObjectKwargs(const GstTagList *tags);
 
     struct GVal final
@@ -3,8 +3,13 @@
 
 #include "PothosToGStreamer.hpp"
 #include "GStreamer.hpp"
+#include "GStreamerByteStore.hpp"
+#include "GStreamerLatencyMeta.hpp"
+#include "GStreamerReplicas.hpp"
 #include "GStreamerTypes.hpp"
 #include <gst/app/gstappsrc.h>
+#include <algorithm>
+#include <mutex>
 #include <string>
 
 static std::string gstFlowToString(GstFlowReturn gstFlowReturn)
@@ -17,26 +22,55 @@ namespace
 
     class PothosToGStreamerRunState {
     private:
+        GStreamer *m_gstreamerBlock;
         std::unique_ptr< GstAppSrc, GstTypes::GstObjectUnrefFunc > m_gstAppSource;
         GstTypes::GstCapsPtr m_baseCaps;
         bool m_tagSendAppDataOnce;
         std::atomic_bool m_needData;
+        std::atomic_bool m_filled;
+        std::shared_ptr< GStreamerByteStore > m_byteStore;
+        std::mutex m_offsetMutex;
+        uint64_t m_offset;
+        uint64_t m_seekCount;
+        std::atomic_bool m_byteStoreEos;
+        GStreamerPortStats *m_portStats;
+        std::shared_ptr< GstTypes::BlockPool > m_blockPool;
+
+        //! Most bytes pushed from the byte store in one buffer
+        static constexpr size_t BYTE_STORE_READ_SIZE = 64 * 1024;
 
         static void need_data(GstAppSrc * /* src */, guint /* length */, gpointer user_data)
         {
             auto self = static_cast< PothosToGStreamerRunState* >( user_data );
             self->m_needData = true;
+            self->m_gstreamerBlock->notifyWork();
         }
 
         static void enough_data(GstAppSrc * /* src */, gpointer user_data)
         {
             auto self = static_cast< PothosToGStreamerRunState* >( user_data );
             self->m_needData = false;
+            self->m_filled = true;
         }
 
-        static gboolean seek_data(GstAppSrc * /* src */, guint64 /* offset */, gpointer /* user_data */)
+        static gboolean seek_data(GstAppSrc * /* src */, guint64 offset, gpointer user_data)
         {
-            return FALSE;
+            auto self = static_cast< PothosToGStreamerRunState* >( user_data );
+            if ( !self->m_byteStore )
+            {
+                return FALSE;
+            }
+
+            {
+                std::lock_guard< std::mutex > lock( self->m_offsetMutex );
+                self->m_offset = offset;
+                ++self->m_seekCount;
+                // The appsrc flushes its queue once we return, then asks for data at the new offset
+                self->m_needData = false;
+            }
+            self->m_byteStoreEos = false;
+            self->m_gstreamerBlock->notifyWork();
+            return TRUE;
         }
 
         static GstAppSrc* getAppSrcByName(GStreamerSubWorker *gstreamerSubWorker)
@@ -56,11 +90,20 @@ namespace
         PothosToGStreamerRunState(PothosToGStreamerRunState&&) = delete;
         PothosToGStreamerRunState& operator=(PothosToGStreamerRunState&&) = delete;
 
-        explicit PothosToGStreamerRunState(GStreamerSubWorker *gstreamerSubWorker) :
+        PothosToGStreamerRunState(GStreamerSubWorker *gstreamerSubWorker, std::shared_ptr< GStreamerByteStore > byteStore, GStreamerPortStats *portStats) :
+            m_gstreamerBlock( gstreamerSubWorker->gstreamerBlock() ),
             m_gstAppSource( getAppSrcByName( gstreamerSubWorker ) ),
             m_baseCaps( nullptr ),
             m_tagSendAppDataOnce( true ),
-            m_needData( false )
+            m_needData( false ),
+            m_filled( false ),
+            m_byteStore( std::move( byteStore ) ),
+            m_offsetMutex( ),
+            m_offset( 0 ),
+            m_seekCount( 0 ),
+            m_byteStoreEos( false ),
+            m_portStats( portStats ),
+            m_blockPool( std::make_shared< GstTypes::BlockPool >() )
         {
             // Save the caps if they were set from pipeline
             m_baseCaps.reset( gst_app_src_get_caps( m_gstAppSource.get() ) );
@@ -73,16 +116,23 @@ namespace
             };
             gst_app_src_set_callbacks( m_gstAppSource.get(), &gstAppSrcCallbacks, this, nullptr);
 
-            /* Our GstAppSrc can only stream from Pothos, can't seek */
-            gst_app_src_set_stream_type( m_gstAppSource.get(), GST_APP_STREAM_TYPE_STREAM );
+            PothosToGStreamer::setupStreamAppSrc( m_gstreamerBlock, m_gstAppSource.get() );
 
-            g_object_set( m_gstAppSource.get(),
-    //            "is-live",      FALSE,
-    //            "format",       GST_FORMAT_TIME,
-                "block",        FALSE,              /* We can't block in Pothos work() method */
-                "do-timestamp", TRUE,               /* Get GstAppSrc to time stamp our buffers */
-                nullptr                             /* List termination */
-            );
+            if ( m_byteStore )
+            {
+                /* Bytes read back from the store, at whatever offset GStreamer seeks to */
+                gst_app_src_set_stream_type( m_gstAppSource.get(), GST_APP_STREAM_TYPE_RANDOM_ACCESS );
+                g_object_set( m_gstAppSource.get(),
+                    "is-live",      FALSE,
+                    "format",       GST_FORMAT_BYTES,
+                    "do-timestamp", FALSE,
+                    nullptr
+                );
+                if ( m_byteStore->complete() )
+                {
+                    gst_app_src_set_size( m_gstAppSource.get(), static_cast< gint64 >( m_byteStore->size() ) );
+                }
+            }
         }
 
         ~PothosToGStreamerRunState()
@@ -126,6 +176,12 @@ namespace
             return m_needData.load();
         }
 
+        //! GstAppSrc queue has been filled at least once
+        bool filled() const
+        {
+            return m_filled.load();
+        }
+
         bool tagSendAppDataOnce()
         {
             if ( m_tagSendAppDataOnce )
@@ -140,6 +196,90 @@ namespace
         {
             return gst_element_send_event( GST_ELEMENT( gstAppSource() ), event) == TRUE;
         }
+
+        //! Blocks for the copies of the packet payloads the GStreamer buffers wrap, outlives the run state while buffers are in the pipeline
+        const std::shared_ptr< GstTypes::BlockPool >& blockPool() const
+        {
+            return m_blockPool;
+        }
+
+        GStreamerByteStore* byteStore()
+        {
+            return m_byteStore.get();
+        }
+
+        //! @return true if there are bytes in the store to push at the current offset, or the EOS after the last of them
+        bool canServeByteStore()
+        {
+            if ( !needData() )
+            {
+                return false;
+            }
+            uint64_t offset;
+            {
+                std::lock_guard< std::mutex > lock( m_offsetMutex );
+                offset = m_offset;
+            }
+            return ( offset < m_byteStore->size() ) || ( m_byteStore->complete() && !m_byteStoreEos );
+        }
+
+        //! No more bytes go in the byte store, the stream size is now known
+        void byteStoreComplete()
+        {
+            m_byteStore->setComplete();
+            gst_app_src_set_size( gstAppSource(), static_cast< gint64 >( m_byteStore->size() ) );
+        }
+
+        //! Push bytes from the store at the current offset, while the appsrc wants data
+        void serveByteStore()
+        {
+            while ( needData() )
+            {
+                uint64_t offset;
+                uint64_t seekCount;
+                {
+                    std::lock_guard< std::mutex > lock( m_offsetMutex );
+                    offset = m_offset;
+                    seekCount = m_seekCount;
+                }
+
+                auto gstBuffer = m_byteStore->read( offset, BYTE_STORE_READ_SIZE );
+                if ( !gstBuffer )
+                {
+                    // Nothing more will come at this offset
+                    if ( m_byteStore->complete() && offset >= m_byteStore->size() && !m_byteStoreEos.exchange( true ) )
+                    {
+                        sendEos();
+                    }
+                    return;
+                }
+
+                const auto size = gst_buffer_get_size( gstBuffer.get() );
+                GST_BUFFER_OFFSET( gstBuffer.get() ) = offset;
+                GST_BUFFER_OFFSET_END( gstBuffer.get() ) = offset + size;
+
+                GstFlowReturn flowReturn;
+                {
+                    // Pushed under the lock, so a seek lands either before, and the bytes are dropped here,
+                    // or after, and they are flushed with the rest of the queue
+                    std::lock_guard< std::mutex > lock( m_offsetMutex );
+                    // Seeked since reading, the bytes are from the wrong offset
+                    if ( seekCount != m_seekCount )
+                    {
+                        continue;
+                    }
+                    m_offset = offset + size;
+                    flowReturn = gst_app_src_push_buffer( gstAppSource(), gstBuffer.release() );
+                }
+                if ( flowReturn != GST_FLOW_OK )
+                {
+                    m_portStats->flowError();
+                    poco_warning( GstTypes::logger(), "PothosToGStreamer::serveByteStore() flow_return = " + std::to_string( flowReturn ) + " (" + gstFlowToString( flowReturn ) + ")" );
+                    return;
+                }
+                m_portStats->buffer( size );
+            }
+        }
     };  // class PothosToGStreamerRunState
 
     #define check_run_state_ptr() do { \
@@ -151,16 +291,57 @@ namespace
     private:
         Pothos::InputPort *m_pothosInputPort;
         std::shared_ptr< std::string > m_tag_app_data;
+        GstAppStreamType m_streamType;
+        std::string m_backingFile;
         std::unique_ptr< PothosToGStreamerRunState > m_runState;
 
+        void makeRunState()
+        {
+            std::shared_ptr< GStreamerByteStore > byteStore;
+            if ( m_streamType == GST_APP_STREAM_TYPE_RANDOM_ACCESS )
+            {
+                byteStore = ( m_backingFile.empty() ) ?
+                    std::make_shared< GStreamerByteStore >() :
+                    std::make_shared< GStreamerByteStore >( m_backingFile );
+            }
+            m_runState.reset( new PothosToGStreamerRunState( this, std::move( byteStore ), &portStats() ) );
+        }
+
+        //! Random access: everything received goes in the byte store, GStreamer reads it back from there
+        void workByteStore()
+        {
+            auto byteStore = m_runState->byteStore();
+            while ( m_pothosInputPort->hasMessage() )
+            {
+                const auto message = m_pothosInputPort->popMessage();
+                // A store backed by a file is complete, the input is not used
+                if ( message.type() != typeid( Pothos::Packet ) || byteStore->complete() )
+                {
+                    portStats().drop();
+                    continue;
+                }
+
+                const auto &packet = message.extract< Pothos::Packet >();
+                byteStore->append( packet.payload );
+                if ( GstTypes::ifKeyExtract< bool >( packet.metadata, GstTypes::PACKET_META_EOS ).value( false ) )
+                {
+                    m_runState->byteStoreComplete();
+                }
+            }
+
+            m_runState->serveByteStore();
+        }
+
     public:
         PothosToGStreamerImpl(const PothosToGStreamerImpl&) = delete;              // No copy constructor
         PothosToGStreamerImpl& operator= (const PothosToGStreamerImpl&) = delete;  // No assignment operator
 
-        PothosToGStreamerImpl(GStreamer* gstreamerBlock, GstAppSrc* gstAppSource) :
-            GStreamerSubWorker( gstreamerBlock, GstTypes::gcharToString( GstTypes::GCharPtr( gst_element_get_name( gstAppSource ) ).get() ).value() ),
+        PothosToGStreamerImpl(GStreamer* gstreamerBlock, const std::string &elementName) :
+            GStreamerSubWorker( gstreamerBlock, elementName ),
             m_pothosInputPort( gstreamerBlock->setupInput( name() ) ), // Allocate Pothos input port for GStreamer
             m_tag_app_data( std::make_shared< std::string >() ),
+            m_streamType( GST_APP_STREAM_TYPE_STREAM ),
+            m_backingFile( ),
             m_runState()
         {
             // Register Callable and Probe
@@ -183,6 +364,18 @@ namespace
                 // registerCallable does not register our slot since this method takes no arguments
                 gstreamerBlock->registerSlot( sendEosName );
             }
+
+            // Register random access setters
+            {
+                gstreamerBlock->registerCallable(
+                    this->funcName( "setStreamType" ),
+                    Pothos::Callable(&PothosToGStreamerImpl::setStreamType).bind( std::ref( *this ), 0)
+                );
+                gstreamerBlock->registerCallable(
+                    this->funcName( "setBackingFile" ),
+                    Pothos::Callable(&PothosToGStreamerImpl::setBackingFile).bind( std::ref( *this ), 0)
+                );
+            }
         }
 
         ~PothosToGStreamerImpl() override = default;
@@ -197,10 +390,60 @@ namespace
             *m_tag_app_data = tag_app_data;
         }
 
+        void setStreamType(const std::string &streamType)
+        {
+            static constexpr std::array< std::pair< const char * const, GstAppStreamType >, 2 > streamTypeOptions =
+            { {
+                { "STREAM"        , GST_APP_STREAM_TYPE_STREAM        },
+                { "RANDOM_ACCESS" , GST_APP_STREAM_TYPE_RANDOM_ACCESS }
+            } };
+
+            GstAppStreamType value;
+            try
+            {
+                value = GstTypes::findValueByKey( std::begin(streamTypeOptions), std::end(streamTypeOptions), streamType );
+            }
+            catch (const Pothos::NotFoundException &e)
+            {
+                throw Pothos::InvalidArgumentException( "PothosToGStreamer::setStreamType(" + streamType + ")", e.message() );
+            }
+            // Every replica would have to read from the one byte store
+            if ( value != GST_APP_STREAM_TYPE_STREAM && gstreamerBlock()->replicaSet() != nullptr )
+            {
+                throw Pothos::InvalidArgumentException( "PothosToGStreamer::setStreamType(" + streamType + ")", "Only STREAM can be used with replicas" );
+            }
+            m_streamType = value;
+        }
+
+        bool canReplicate() const override
+        {
+            return m_streamType == GST_APP_STREAM_TYPE_STREAM;
+        }
+
+        void setBackingFile(const std::string &fileName)
+        {
+            m_backingFile = fileName;
+        }
+
         void activate() override
         {
+            // Declared elements may not exist yet, they are bound once added to the pipeline
+            if ( declared() )
+            {
+                bind();
+                return;
+            }
             // Get current instance of GStreamer app source
-            m_runState.reset( new PothosToGStreamerRunState( this ) );
+            makeRunState();
+        }
+
+        bool bind() override
+        {
+            if ( !m_runState && gstreamerBlock()->getPipelineElementByName( name() ) )
+            {
+                makeRunState();
+            }
+            return static_cast< bool >( m_runState );
         }
 
         void deactivate() override
@@ -208,6 +451,44 @@ namespace
             m_runState.reset();
         }
 
+        double occupancy() override
+        {
+            if ( !m_runState )
+            {
+                return 0.0;
+            }
+            const auto hasInput = m_pothosInputPort->hasMessage();
+            if ( m_runState->byteStore() )
+            {
+                return ( hasInput || m_runState->canServeByteStore() ) ? 1.0 : 0.0;
+            }
+            // Input waits in Pothos until the appsrc asks for more
+            if ( !hasInput || !m_runState->needData() )
+            {
+                return 0.0;
+            }
+
+            // The emptier the appsrc queue, the sooner it runs dry
+            const auto appSrc = m_runState->gstAppSource();
+            const auto maxBytes = gst_app_src_get_max_bytes( appSrc );
+            if ( maxBytes == 0 )
+            {
+                return 1.0;
+            }
+            const auto level = static_cast< double >( gst_app_src_get_current_level_bytes( appSrc ) ) / static_cast< double >( maxBytes );
+            return std::max( 0.01, 1.0 - level );
+        }
+
+        bool prerolled() override
+        {
+            if ( !m_runState )
+            {
+                return declared();
+            }
+            // Ready once the queue is full, or every packet we have so far has been pushed
+            return m_runState->filled() || !m_pothosInputPort->hasMessage();
+        }
+
         bool sendGstreamerAppTags()
         {
             GstTagList *gstTagList = gst_tag_list_new(
@@ -248,7 +529,7 @@ namespace
 
         bool sendToGStreamer(const Pothos::Packet &packet)
         {
-            const std::string funcName( "PothosToGStreamer::sendToGStreamer" );
+            static const std::string funcName( "PothosToGStreamer::sendToGStreamer" );
 
             // Try to push a GStreamer tag on first buffer push
             if ( m_runState->tagSendAppDataOnce() )
@@ -256,13 +537,16 @@ namespace
                 sendGstreamerAppTags();
             }
 
+            // Counted from here, the tags are only sent once
+            GStreamerPortStats::AllocationScope allocationScope( portStats() );
+
             // If GStreamer AppSrc is full bail
             if ( m_runState->needData() == false )
             {
                 return false;
             }
 
-            auto gstBuffer = GstTypes::makeGstBufferFromPacket( packet );
+            auto gstBuffer = GstTypes::makeGstBufferFromPacket( packet, m_runState->blockPool() );
 
             // If GstBuffer could not be allocated, bail
             if ( !gstBuffer )
@@ -295,9 +579,26 @@ namespace
                 }
             }
 
+            if ( gstreamerBlock()->measureLatency() )
+            {
+                GstLatencyMeta::stamp( gstBuffer.get() );
+            }
+
+            const auto bytes = gst_buffer_get_size( gstBuffer.get() );
+            const auto maxBytes = gst_app_src_get_max_bytes( m_runState->gstAppSource() );
+            if ( maxBytes != 0 )
+            {
+                portStats().occupancy( static_cast< double >( gst_app_src_get_current_level_bytes( m_runState->gstAppSource() ) ) / static_cast< double >( maxBytes ) );
+            }
+
             const auto flowReturn = gst_app_src_push_buffer( m_runState->gstAppSource(), gstBuffer.release() );
-            if ( flowReturn != GST_FLOW_OK )
+            if ( flowReturn == GST_FLOW_OK )
             {
+                portStats().buffer( bytes );
+            }
+            else
+            {
+                portStats().flowError();
                 const auto flowStr = gstFlowToString( flowReturn );
                 poco_warning( GstTypes::logger(), funcName + " flow_return = " + std::to_string( flowReturn ) + " (" + flowStr + ")" );
             }
@@ -311,9 +612,15 @@ namespace
             return ( flowReturn >= 0 );
         }
 
-        void work(long long /* maxTimeoutNs */) override
+        void work() override
         {
-            if ( !m_pothosInputPort->hasMessage() )
+            if ( m_runState && m_runState->byteStore() )
+            {
+                workByteStore();
+                return;
+            }
+
+            if ( !m_runState || !m_pothosInputPort->hasMessage() )
             {
                 return;
             }
@@ -332,10 +639,18 @@ namespace
 
             poco_warning( GstTypes::logger(), "Received message on port "+m_pothosInputPort->name()+" of type we can't handle. Only accept Pothos::Packet" );
             m_pothosInputPort->popMessage();
+            portStats().drop();
         }
 
         void sendEos()
         {
+            // Replicated, the port is fed by the replica set
+            if ( auto replicaSet = gstreamerBlock()->replicaSet() )
+            {
+                replicaSet->sendEos();
+                return;
+            }
+
             check_run_state_ptr();
 
             m_runState->sendEos();
@@ -343,6 +658,11 @@ namespace
 
         guint64 getCurrentLevelBytes() const
         {
+            if ( auto replicaSet = gstreamerBlock()->replicaSet() )
+            {
+                return replicaSet->getCurrentLevelBytes();
+            }
+
             check_run_state_ptr();
 
             return gst_app_src_get_current_level_bytes( m_runState->gstAppSource() );
@@ -351,16 +671,46 @@ namespace
 
 }  // namespace
 
+std::unique_ptr< GStreamerSubWorker > PothosToGStreamer::make(GStreamer* gstreamerBlock, const std::string &elementName)
+{
+    return std::unique_ptr< GStreamerSubWorker >(
+        new PothosToGStreamerImpl(
+            gstreamerBlock,
+            elementName
+        )
+    );
+}
+
+void PothosToGStreamer::setupStreamAppSrc(GStreamer* gstreamerBlock, GstAppSrc* gstAppSrc)
+{
+    /* Our GstAppSrc can only stream from Pothos, can't seek */
+    gst_app_src_set_stream_type( gstAppSrc, GST_APP_STREAM_TYPE_STREAM );
+
+    g_object_set( gstAppSrc,
+//            "is-live",      FALSE,
+//            "format",       GST_FORMAT_TIME,
+        "block",        FALSE,              /* We can't block in Pothos work() method */
+        "do-timestamp", TRUE,               /* Get GstAppSrc to time stamp our buffers */
+        nullptr                             /* List termination */
+    );
+
+    if ( gstreamerBlock->offlineMode() )
+    {
+        /* There is no clock to time stamp from, keep the time stamps from the packets */
+        g_object_set( gstAppSrc,
+            "is-live",      FALSE,
+            "format",       GST_FORMAT_TIME,
+            "do-timestamp", FALSE,
+            nullptr
+        );
+    }
+}
+
 std::unique_ptr< GStreamerSubWorker > PothosToGStreamer::makeIfType(GStreamer* gstreamerBlock, GstElement* gstElement)
 {
     if ( GST_IS_APP_SRC( gstElement ) )
     {
-        return std::unique_ptr< GStreamerSubWorker >(
-            new PothosToGStreamerImpl(
-                gstreamerBlock,
-                reinterpret_cast< GstAppSrc* >( gstElement )
-            )
-        );
+        return make( gstreamerBlock, GstTypes::gcharToString( GstTypes::GCharPtr( gst_element_get_name( gstElement ) ).get() ).value() );
     }
     return nullptr;
 }
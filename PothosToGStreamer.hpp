@@ -5,9 +5,15 @@
 
 #include "GStreamerSubWorker.hpp"
 #include <gst/gstelement.h>
+#include <gst/app/gstappsrc.h>
 #include <memory>
+#include <string>
 
 namespace PothosToGStreamer
 {
+    std::unique_ptr< GStreamerSubWorker > make(GStreamer* gstreamerBlock, const std::string &elementName);
     std::unique_ptr< GStreamerSubWorker > makeIfType(GStreamer* gstreamerBlock, GstElement* gstElement);
+
+    //! Set up an appsrc to stream Pothos packets, time stamped by the appsrc unless in offline mode
+    void setupStreamAppSrc(GStreamer* gstreamerBlock, GstAppSrc* gstAppSrc);
 }  // namespace PothosToGStreamer
@@ -2,18 +2,29 @@
 /// SPDX-License-Identifier: BSL-1.0
 
 #include "GStreamer.hpp"
+#include "GStreamerByteStore.hpp"
+#include "GStreamerLatencyMeta.hpp"
+#include "GStreamerPipelineDescription.hpp"
+#include "GStreamerPortStats.hpp"
+#include "GStreamerStatic.hpp"
 #include "GStreamerTypes.hpp"
 #include <Poco/TemporaryFile.h>
 #include <Pothos/Framework.hpp>
 #include <Pothos/Proxy.hpp>
 #include <Pothos/Testing.hpp>
+#include <chrono>
 #include <complex>
 #include <fstream>
 #include <functional>
 #include <iostream>
 #include <json.hpp>
+#include <thread>
 #include <tuple>
 
+#ifdef __linux__
+#include <sched.h>
+#endif
+
 using json = nlohmann::json;
 
 #define POTHOS_TEST_EQUAL_GCHAR(s1, s2)  POTHOS_TEST_EQUALA((s1), (s2), (std::min( strlen(s1), strlen(s2) )+1))
@@ -28,8 +39,46 @@ std::vector< T > createSequentialValues(typename std::vector< T >::size_type siz
     return v;
 }
 
+POTHOS_TEST_BLOCK(testPath, test_gstreamer_static_init)
+{
+    // GStreamer is only initialized on first use
+    POTHOS_TEST_TRUE( GstStatic::init() == nullptr );
+    POTHOS_TEST_TRUE( gst_is_initialized() == TRUE );
+    POTHOS_TEST_TRUE( GstStatic::getInitError() == nullptr );
+
+    // Unknown factories are skipped, repeated ones only loaded once
+    GstStatic::preload( { "fakesrc", "fakesink", "not_a_factory" } );
+    GstStatic::preload( { "fakesrc" } );
+
+    POTHOS_TEST_CHECKPOINT();
+}
+
+POTHOS_TEST_BLOCK(testPath, test_gstreamer_static_clock_domain)
+{
+    GstStatic::init();
+
+    auto domain = GstStatic::ClockDomain::acquire( "capture" );
+    auto sameDomain = GstStatic::ClockDomain::acquire( "capture" );
+    auto otherDomain = GstStatic::ClockDomain::acquire( "other" );
+
+    // Blocks in one domain share the clock and base time
+    POTHOS_TEST_TRUE( domain == sameDomain );
+    POTHOS_TEST_TRUE( domain != otherDomain );
+    POTHOS_TEST_TRUE( domain->clock() != nullptr );
+
+    std::unique_ptr< GstPipeline, GstTypes::GstObjectUnrefFunc > pipeline( GST_PIPELINE( gst_object_ref_sink( gst_pipeline_new( nullptr ) ) ) );
+    domain->apply( pipeline.get() );
+    POTHOS_TEST_EQUAL( gst_element_get_base_time( GST_ELEMENT( pipeline.get() ) ), domain->baseTime() );
+    POTHOS_TEST_EQUAL( gst_element_get_start_time( GST_ELEMENT( pipeline.get() ) ), GST_CLOCK_TIME_NONE );
+
+    POTHOS_TEST_CHECKPOINT();
+}
+
 POTHOS_TEST_BLOCK(testPath, test_gstreamer_types_gvalue_to_object)
 {
+    // GStreamer types are registered by initialization
+    POTHOS_TEST_TRUE( GstStatic::init() == nullptr );
+
     {
         const std::string testString( "test 1, 2" );
         {
@@ -155,6 +204,56 @@ POTHOS_TEST_BLOCK(testPath, test_gstreamer_types_gvalue_to_object)
     }
 }
 
+POTHOS_TEST_BLOCK(testPath, test_gstreamer_types_object_to_gvalue)
+{
+    POTHOS_TEST_TRUE( GstStatic::init() == nullptr );
+
+    // Numbers are converted to the GValue type
+    {
+        GstTypes::GVal value( G_TYPE_UINT );
+        GstTypes::objectToGValue( Pothos::Object( 42 ), value() );
+        POTHOS_TEST_EQUAL( g_value_get_uint( value() ), 42u );
+    }
+    {
+        GstTypes::GVal value( G_TYPE_DOUBLE );
+        GstTypes::objectToGValue( Pothos::Object( 3 ), value() );
+        POTHOS_TEST_EQUAL( g_value_get_double( value() ), 3.0 );
+    }
+    {
+        GstTypes::GVal value( G_TYPE_BOOLEAN );
+        GstTypes::objectToGValue( Pothos::Object( true ), value() );
+        POTHOS_TEST_TRUE( g_value_get_boolean( value() ) == TRUE );
+    }
+    {
+        GstTypes::GVal value( G_TYPE_STRING );
+        GstTypes::objectToGValue( Pothos::Object( std::string( "test" ) ), value() );
+        POTHOS_TEST_EQUAL_GCHAR( g_value_get_string( value() ), "test" );
+    }
+
+    // Enums from their nick, and back from gvalueToObject
+    {
+        GstTypes::GVal value( GST_TYPE_STATE );
+        GstTypes::objectToGValue( Pothos::Object( std::string( "playing" ) ), value() );
+        POTHOS_TEST_EQUAL( g_value_get_enum( value() ), GST_STATE_PLAYING );
+
+        GstTypes::GVal copy( GST_TYPE_STATE );
+        GstTypes::objectToGValue( value.toPothosObject(), copy() );
+        POTHOS_TEST_EQUAL( g_value_get_enum( copy() ), GST_STATE_PLAYING );
+    }
+
+    // Caps from a string
+    {
+        GstTypes::GVal value( GST_TYPE_CAPS );
+        GstTypes::objectToGValue( Pothos::Object( std::string( "audio/x-raw,channels=1" ) ), value() );
+        POTHOS_TEST_TRUE( gst_value_get_caps( value() ) != nullptr );
+    }
+
+    {
+        GstTypes::GVal value( G_TYPE_INT );
+        POTHOS_TEST_THROWS( GstTypes::objectToGValue( Pothos::Object( std::string( "not a number" ) ), value() ), Pothos::InvalidArgumentException );
+    }
+}
+
 POTHOS_TEST_BLOCK(testPath, test_gstreamer_types_if_key_extract_or_default)
 {
     Pothos::ObjectKwargs args;
@@ -242,6 +341,8 @@ static void outputArgumentError(GError **outError)
 
 POTHOS_TEST_BLOCK(testPath, test_gstreamer_types_gerror_ptr)
 {
+    POTHOS_TEST_TRUE( GstStatic::init() == nullptr );
+
     GstTypes::GErrorPtr refError( newTestGError() );
     GstTypes::GErrorPtr gerrorPtr;
     outputArgumentError( GstTypes::uniqueOutArg( gerrorPtr ) );
@@ -251,6 +352,111 @@ POTHOS_TEST_BLOCK(testPath, test_gstreamer_types_gerror_ptr)
     POTHOS_TEST_EQUAL_GCHAR( refError->message, gerrorPtr->message );
 }
 
+POTHOS_TEST_BLOCK(testPath, test_gstreamer_pipeline_description)
+{
+    {
+        const auto description = GstPipelineDescription::parse( "appsrc name=in ! audioconvert ! appsink name=out" );
+        POTHOS_TEST_TRUE( description.isSpecified() );
+        POTHOS_TEST_EQUAL( description.value().appSrcNames.size(), 1 );
+        POTHOS_TEST_EQUAL( description.value().appSrcNames[0], "in" );
+        POTHOS_TEST_EQUAL( description.value().appSinkNames.size(), 1 );
+        POTHOS_TEST_EQUAL( description.value().appSinkNames[0], "out" );
+        POTHOS_TEST_EQUAL( description.value().factories.size(), 3 );
+    }
+
+    // Quoted names, spaced assignments, caps and bins
+    {
+        const auto description = GstPipelineDescription::parse(
+            "audiotestsrc ! audio/x-raw,format=S8,channels=1 ! tee name=t "
+            "t. ! queue ! appsink name=\"out 1\" "
+            "( t. ! queue ! appsink name = out2 caps=\"audio/x-raw, rate=(int)8000\" )" );
+        POTHOS_TEST_TRUE( description.isSpecified() );
+        POTHOS_TEST_EQUAL( description.value().appSrcNames.size(), 0 );
+        POTHOS_TEST_EQUAL( description.value().appSinkNames.size(), 2 );
+        POTHOS_TEST_EQUAL( description.value().appSinkNames[0], "out 1" );
+        POTHOS_TEST_EQUAL( description.value().appSinkNames[1], "out2" );
+    }
+
+    // Typed values are not bins
+    {
+        const auto description = GstPipelineDescription::parse(
+            "appsrc name=in ! capsfilter caps=audio/x-raw,rate=(int)8000 ! audio/x-raw,channels=(int)1 ! appsink name=out" );
+        POTHOS_TEST_TRUE( description.isSpecified() );
+        POTHOS_TEST_EQUAL( description.value().appSrcNames.size(), 1 );
+        POTHOS_TEST_EQUAL( description.value().appSinkNames.size(), 1 );
+        POTHOS_TEST_EQUAL( description.value().appSinkNames[0], "out" );
+        POTHOS_TEST_EQUAL( description.value().factories.size(), 3 );
+    }
+
+    // Unnamed appsink can not be resolved without creating the pipeline
+    {
+        POTHOS_TEST_TRUE( !GstPipelineDescription::parse( "fakesrc ! appsink" ).isSpecified() );
+    }
+
+    // Unterminated quote
+    {
+        POTHOS_TEST_TRUE( !GstPipelineDescription::parse( "appsrc name=\"in ! appsink name=out" ).isSpecified() );
+    }
+}
+
+POTHOS_TEST_BLOCK(testPath, test_gstreamer_byte_store)
+{
+    POTHOS_TEST_TRUE( GstStatic::init() == nullptr );
+
+    const auto readString = [](const GStreamerByteStore &store, uint64_t offset, size_t maxSize)
+    {
+        auto gstBuffer = store.read( offset, maxSize );
+        if ( !gstBuffer )
+        {
+            return std::string( "<none>" );
+        }
+        std::string bytes( gst_buffer_get_size( gstBuffer.get() ), '\0' );
+        gst_buffer_extract( gstBuffer.get(), 0, &bytes[ 0 ], bytes.size() );
+        return bytes;
+    };
+
+    const auto makeChunk = [](const std::string &bytes)
+    {
+        Pothos::BufferChunk chunk( bytes.size() );
+        std::copy( bytes.begin(), bytes.end(), chunk.as< char* >() );
+        return chunk;
+    };
+
+    {
+        GStreamerByteStore store;
+        POTHOS_TEST_TRUE( !store.complete() );
+        store.append( makeChunk( "abc" ) );
+        store.append( Pothos::BufferChunk( 0 ) );
+        store.append( makeChunk( "defgh" ) );
+        POTHOS_TEST_EQUAL( store.size(), 8 );
+
+        // Reads stop at the end of the chunk holding the offset
+        POTHOS_TEST_EQUAL( readString( store, 0, 100 ), "abc" );
+        POTHOS_TEST_EQUAL( readString( store, 1, 1 ), "b" );
+        POTHOS_TEST_EQUAL( readString( store, 3, 100 ), "defgh" );
+        POTHOS_TEST_EQUAL( readString( store, 5, 2 ), "fg" );
+        // Not in the store yet
+        POTHOS_TEST_EQUAL( readString( store, 8, 100 ), "<none>" );
+
+        store.setComplete();
+        POTHOS_TEST_TRUE( store.complete() );
+    }
+
+    {
+        auto tempFile = Poco::TemporaryFile();
+        std::ofstream( tempFile.path(), std::ios::binary ) << "0123456789";
+
+        GStreamerByteStore store( tempFile.path() );
+        POTHOS_TEST_TRUE( store.complete() );
+        POTHOS_TEST_EQUAL( store.size(), 10 );
+        POTHOS_TEST_EQUAL( readString( store, 0, 4 ), "0123" );
+        POTHOS_TEST_EQUAL( readString( store, 7, 100 ), "789" );
+        POTHOS_TEST_EQUAL( readString( store, 10, 1 ), "<none>" );
+    }
+
+    POTHOS_TEST_THROWS( GStreamerByteStore( "/nonexistent/gstreamer_byte_store" ), Pothos::InvalidArgumentException );
+}
+
 POTHOS_TEST_BLOCK(testPath, test_gstreamer_source)
 {
     auto vector_source = Pothos::BlockRegistry::make( "/blocks/vector_source", "int8" );
@@ -492,6 +698,631 @@ POTHOS_TEST_BLOCK(testPath, test_gstreamer_passthrough)
     collectorSink.call("verifyTestPlan", expected);
 }
 
+POTHOS_TEST_BLOCK(testPath, test_gstreamer_metadata_mode)
+{
+    {
+        // Blocks given back are handed out again
+        auto pool = std::make_shared< GstTypes::BlockPool >();
+        auto *block = pool->allocate( 64 );
+        pool->deallocate( block, 64 );
+        POTHOS_TEST_TRUE( pool->allocate( 64 ) == block );
+        pool->deallocate( block, 64 );
+    }
+
+    const char passthrough_pipeline[]{ "appsrc name=in ! appsink name=out" };
+
+    auto feederSource = Pothos::BlockRegistry::make( "/blocks/feeder_source", "int8" );
+
+    auto gstreamer = Pothos::BlockRegistry::make( "/media/gstreamer", passthrough_pipeline );
+    POTHOS_TEST_THROWS( gstreamer.call( "setMetadataMode", std::string( "NONE" ) ), Pothos::Exception );
+    gstreamer.call( "setMetadataMode", std::string( "MINIMAL" ) );
+
+    auto reinterpret = Pothos::BlockRegistry::make( "/blocks/reinterpret", "int8" );
+
+    auto collectorSink = Pothos::BlockRegistry::make( "/blocks/collector_sink", "int8" );
+
+    json testPlan;
+    testPlan[ "enablePackets" ] = true;
+
+    auto expected = feederSource.call("feedTestPlan", testPlan.dump());
+
+    {
+        Pothos::Topology topology;
+
+        topology.connect( feederSource, 0 , gstreamer, "in" );
+        topology.connect( gstreamer, "out" , reinterpret, 0 );
+        topology.connect( reinterpret, 0 , collectorSink, 0 );
+
+        topology.commit();
+        topology.waitInactive( 1 );
+    }
+
+    collectorSink.call("verifyTestPlan", expected);
+
+    // Only the caps when they change and the EOS at the end
+    const auto packets = collectorSink.call< std::vector< Pothos::Packet > >( "getPackets" );
+    POTHOS_TEST_TRUE( !packets.empty() );
+    for (const auto &packet : packets)
+    {
+        POTHOS_TEST_EQUAL( packet.metadata.count( GstTypes::PACKET_META_PTS ), 0 );
+        POTHOS_TEST_EQUAL( packet.metadata.count( GstTypes::PACKET_META_SEGMENT ), 0 );
+        POTHOS_TEST_TRUE( packet.labels.empty() );
+        if ( packet.payload.length != 0 )
+        {
+            POTHOS_TEST_EQUAL( packet.metadata.count( GstTypes::PACKET_META_EOS ), 0 );
+        }
+    }
+}
+
+POTHOS_TEST_BLOCK(testPath, test_gstreamer_port_stats)
+{
+    {
+        GStreamerPortStats stats;
+        stats.buffer( 100 );
+        stats.buffer( 50 );
+        stats.drop();
+        stats.flowError();
+        stats.occupancy( 0.0 );
+        stats.occupancy( 1.0 );
+        stats.occupancy( 2.0 );
+
+        const auto kwargs = stats.toObjectKwargs();
+        POTHOS_TEST_EQUAL( kwargs.at( "buffers"    ).convert< uint64_t >(), 2 );
+        POTHOS_TEST_EQUAL( kwargs.at( "bytes"      ).convert< uint64_t >(), 150 );
+        POTHOS_TEST_EQUAL( kwargs.at( "drops"      ).convert< uint64_t >(), 1 );
+        POTHOS_TEST_EQUAL( kwargs.at( "flowErrors" ).convert< uint64_t >(), 1 );
+
+        const auto occupancy = kwargs.at( "occupancyHistogram" ).extract< Pothos::ObjectVector >();
+        POTHOS_TEST_EQUAL( occupancy.size(), GStreamerPortStats::OCCUPANCY_BINS );
+        POTHOS_TEST_EQUAL( occupancy.front().convert< uint64_t >(), 1 );
+        // Over full counts as full
+        POTHOS_TEST_EQUAL( occupancy.back().convert< uint64_t >(), 2 );
+
+        // One gap between two buffers
+        uint64_t gaps = 0;
+        for (const auto &bin : kwargs.at( "interArrivalHistogram" ).extract< Pothos::ObjectVector >())
+        {
+            gaps += bin.convert< uint64_t >();
+        }
+        POTHOS_TEST_EQUAL( gaps, 1 );
+
+        stats.reset();
+        POTHOS_TEST_EQUAL( stats.toObjectKwargs().at( "buffers" ).convert< uint64_t >(), 0 );
+    }
+
+    const char passthrough_pipeline[]{ "appsrc name=in ! appsink name=out" };
+
+    auto feederSource = Pothos::BlockRegistry::make( "/blocks/feeder_source", "int8" );
+
+    auto gstreamer = Pothos::BlockRegistry::make( "/media/gstreamer", passthrough_pipeline );
+
+    auto collectorSink = Pothos::BlockRegistry::make( "/blocks/collector_sink", "int8" );
+
+    json testPlan;
+    testPlan[ "enablePackets" ] = true;
+
+    feederSource.call("feedTestPlan", testPlan.dump());
+
+    {
+        Pothos::Topology topology;
+
+        topology.connect( feederSource, 0 , gstreamer, "in" );
+        topology.connect( gstreamer, "out" , collectorSink, 0 );
+
+        topology.commit();
+        topology.waitInactive( 1 );
+    }
+
+    // Kept after deactivation, until the next activation
+    const auto portStats = gstreamer.call< Pothos::ObjectKwargs >( "getPortStats" );
+    const auto &in = portStats.at( "in" ).extract< Pothos::ObjectKwargs >();
+    const auto &out = portStats.at( "out" ).extract< Pothos::ObjectKwargs >();
+    POTHOS_TEST_TRUE( in.at( "buffers" ).convert< uint64_t >() != 0 );
+    POTHOS_TEST_EQUAL( in.at( "bytes" ).convert< uint64_t >(), out.at( "bytes" ).convert< uint64_t >() );
+    POTHOS_TEST_EQUAL( in.at( "flowErrors" ).convert< uint64_t >(), 0 );
+}
+
+POTHOS_TEST_BLOCK(testPath, test_gstreamer_latency)
+{
+    POTHOS_TEST_TRUE( GstStatic::init() == nullptr );
+
+    {
+        GstTypes::GstBufferPtr buffer( gst_buffer_new() );
+        POTHOS_TEST_TRUE( !GstLatencyMeta::elapsedNs( buffer.get() ).isSpecified() );
+
+        GstLatencyMeta::stamp( buffer.get() );
+        POTHOS_TEST_TRUE( GstLatencyMeta::elapsedNs( buffer.get() ).isSpecified() );
+
+        // Carried over to buffers made from it
+        GstTypes::GstBufferPtr copy( gst_buffer_copy( buffer.get() ) );
+        POTHOS_TEST_TRUE( GstLatencyMeta::elapsedNs( copy.get() ).isSpecified() );
+    }
+
+    {
+        GStreamerPortStats stats;
+        POTHOS_TEST_TRUE( stats.latencyToObjectKwargs().empty() );
+        for (int64_t ns = 1; ns <= 100; ++ns)
+        {
+            stats.latency( ns );
+        }
+        const auto latency = stats.latencyToObjectKwargs();
+        POTHOS_TEST_EQUAL( latency.at( "samples" ).convert< uint64_t >(), 100 );
+        POTHOS_TEST_EQUAL( latency.at( "p50" ).convert< int64_t >(), 51 );
+        POTHOS_TEST_EQUAL( latency.at( "p99" ).convert< int64_t >(), 99 );
+        POTHOS_TEST_EQUAL( latency.at( "max" ).convert< int64_t >(), 100 );
+    }
+
+    const char pipeline[]{ "appsrc name=in ! identity ! appsink name=out" };
+
+    auto feederSource = Pothos::BlockRegistry::make( "/blocks/feeder_source", "int8" );
+
+    auto gstreamer = Pothos::BlockRegistry::make( "/media/gstreamer", pipeline );
+    gstreamer.call( "setMeasureLatency", true );
+
+    auto collectorSink = Pothos::BlockRegistry::make( "/blocks/collector_sink", "int8" );
+
+    json testPlan;
+    testPlan[ "enablePackets" ] = true;
+
+    feederSource.call("feedTestPlan", testPlan.dump());
+
+    {
+        Pothos::Topology topology;
+
+        topology.connect( feederSource, 0 , gstreamer, "in" );
+        topology.connect( gstreamer, "out" , collectorSink, 0 );
+
+        topology.commit();
+        topology.waitInactive( 1 );
+    }
+
+    const auto packets = collectorSink.call< std::vector< Pothos::Packet > >( "getPackets" );
+    uint64_t measured = 0;
+    for (const auto &packet : packets)
+    {
+        // An EOS on its own has no buffer to measure
+        if ( packet.payload.length != 0 )
+        {
+            POTHOS_TEST_EQUAL( packet.metadata.count( GstTypes::PACKET_META_LATENCY ), 1 );
+            ++measured;
+        }
+    }
+    POTHOS_TEST_TRUE( measured != 0 );
+
+    const auto latencyStats = gstreamer.call< Pothos::ObjectKwargs >( "getLatencyStats" );
+    POTHOS_TEST_EQUAL( latencyStats.count( "in" ), 0 );
+    const auto &out = latencyStats.at( "out" ).extract< Pothos::ObjectKwargs >();
+    POTHOS_TEST_EQUAL( out.at( "samples" ).convert< uint64_t >(), measured );
+    POTHOS_TEST_TRUE( out.at( "p50" ).convert< int64_t >() <= out.at( "max" ).convert< int64_t >() );
+}
+
+POTHOS_TEST_BLOCK(testPath, test_gstreamer_tracer_stats)
+{
+    const char pipeline[]{ "appsrc name=in ! identity name=filter ! appsink name=out" };
+
+    auto feederSource = Pothos::BlockRegistry::make( "/blocks/feeder_source", "int8" );
+
+    auto gstreamer = Pothos::BlockRegistry::make( "/media/gstreamer", pipeline );
+
+    POTHOS_TEST_THROWS( gstreamer.call( "setTracers", std::vector< std::string >{ "unknown" } ), Pothos::Exception );
+    gstreamer.call( "setTracers", std::vector< std::string >{ "latency", "stats" } );
+
+    // Nothing until activated
+    POTHOS_TEST_TRUE( gstreamer.call< Pothos::ObjectKwargs >( "getTracerStats" ).empty() );
+
+    auto collectorSink = Pothos::BlockRegistry::make( "/blocks/collector_sink", "int8" );
+
+    json testPlan;
+    testPlan[ "enablePackets" ] = true;
+
+    feederSource.call("feedTestPlan", testPlan.dump());
+
+    {
+        Pothos::Topology topology;
+
+        topology.connect( feederSource, 0 , gstreamer, "in" );
+        topology.connect( gstreamer, "out" , collectorSink, 0 );
+
+        topology.commit();
+        topology.waitInactive( 1 );
+    }
+
+    const auto tracerStats = gstreamer.call< Pothos::ObjectKwargs >( "getTracerStats" );
+    const auto &elements = tracerStats.at( "elements" ).extract< Pothos::ObjectKwargs >();
+    // Only the elements of this pipeline
+    POTHOS_TEST_EQUAL( elements.count( "filter" ), 1 );
+    POTHOS_TEST_EQUAL( elements.count( "in" ), 1 );
+    POTHOS_TEST_EQUAL( elements.count( "out" ), 1 );
+    POTHOS_TEST_TRUE( tracerStats.count( "pipelineLatency" ) == 1 );
+
+    // The stats tracer records of the filter were matched to it
+    const auto &filter = elements.at( "filter" ).extract< Pothos::ObjectKwargs >();
+    POTHOS_TEST_TRUE( filter.at( "buffers" ).convert< uint64_t >() != 0 );
+    POTHOS_TEST_TRUE( filter.at( "bytes" ).convert< uint64_t >() != 0 );
+}
+
+POTHOS_TEST_BLOCK(testPath, test_gstreamer_element_timing)
+{
+    const char pipeline[]{ "appsrc name=in ! identity name=filter ! appsink name=out" };
+
+    auto feederSource = Pothos::BlockRegistry::make( "/blocks/feeder_source", "int8" );
+
+    auto gstreamer = Pothos::BlockRegistry::make( "/media/gstreamer", pipeline );
+    gstreamer.call( "enableElementTiming", std::vector< std::string >{ "filter" } );
+
+    auto collectorSink = Pothos::BlockRegistry::make( "/blocks/collector_sink", "int8" );
+
+    json testPlan;
+    testPlan[ "enablePackets" ] = true;
+
+    feederSource.call("feedTestPlan", testPlan.dump());
+
+    {
+        Pothos::Topology topology;
+
+        topology.connect( feederSource, 0 , gstreamer, "in" );
+        topology.connect( gstreamer, "out" , collectorSink, 0 );
+
+        topology.commit();
+        topology.waitInactive( 1 );
+    }
+
+    gstreamer.call( "disableElementTiming" );
+
+    // Kept after the probes are removed
+    const auto timing = gstreamer.call< Pothos::ObjectKwargs >( "getElementTiming" );
+    POTHOS_TEST_EQUAL( timing.size(), 1 );
+    const auto &filter = timing.at( "filter" ).extract< Pothos::ObjectKwargs >();
+    const auto count = filter.at( "count" ).convert< uint64_t >();
+    POTHOS_TEST_TRUE( count != 0 );
+    POTHOS_TEST_TRUE( filter.at( "meanNs" ).convert< uint64_t >() <= filter.at( "maxNs" ).convert< uint64_t >() );
+
+    uint64_t binned = 0;
+    for (const auto &bin : filter.at( "histogram" ).extract< Pothos::ObjectVector >())
+    {
+        binned += bin.convert< uint64_t >();
+    }
+    POTHOS_TEST_EQUAL( binned, count );
+}
+
+POTHOS_TEST_BLOCK(testPath, test_gstreamer_replace_bin)
+{
+    const char pipeline[]{ "appsrc name=in ! identity name=filter ! appsink name=out" };
+
+    auto feederSource = Pothos::BlockRegistry::make( "/blocks/feeder_source", "int8" );
+
+    auto gstreamer = Pothos::BlockRegistry::make( "/media/gstreamer", pipeline );
+
+    auto reinterpret = Pothos::BlockRegistry::make( "/blocks/reinterpret", "int8" );
+
+    auto collectorSink = Pothos::BlockRegistry::make( "/blocks/collector_sink", "int8" );
+
+    // Can't replace without a running pipeline
+    POTHOS_TEST_THROWS( gstreamer.call( "replaceBin", "filter", "identity" ), Pothos::RuntimeException );
+
+    json testPlan;
+    testPlan[ "enablePackets" ] = true;
+
+    auto expected = feederSource.call("feedTestPlan", testPlan.dump());
+
+    {
+        Pothos::Topology topology;
+
+        topology.connect( gstreamer, "out" , reinterpret, 0 );
+        topology.connect( reinterpret, 0 , collectorSink, 0 );
+
+        topology.commit();
+
+        // Ports can't be replaced, the filter can while the pipeline is running.
+        // The swap is done when data reaches the filter, so the data is only fed after the call
+        POTHOS_TEST_THROWS( gstreamer.call( "replaceBin", "in", "identity" ), Pothos::InvalidArgumentException );
+        POTHOS_TEST_THROWS( gstreamer.call( "replaceBin", "not_an_element", "identity" ), Pothos::InvalidArgumentException );
+        gstreamer.call( "replaceBin", "filter", "queue ! identity" );
+        // Still waiting for data, the filter can not be replaced twice
+        POTHOS_TEST_THROWS( gstreamer.call( "replaceBin", "filter", "identity" ), Pothos::InvalidArgumentException );
+
+        topology.connect( feederSource, 0 , gstreamer, "in" );
+        topology.commit();
+        topology.waitInactive( 1 );
+
+        // The replacement bin took the name of the filter
+        auto pipeline = gstreamer.call< GstPipeline* >( "getPipeline" );
+        POTHOS_TEST_TRUE( pipeline != nullptr );
+        const GstTypes::GstElementPtr filter( gst_bin_get_by_name( GST_BIN( pipeline ), "filter" ) );
+        POTHOS_TEST_TRUE( filter && GST_IS_BIN( filter.get() ) );
+    }
+
+    // No data lost or duplicated by the swap
+    collectorSink.call("verifyTestPlan", expected);
+}
+
+POTHOS_TEST_BLOCK(testPath, test_gstreamer_replicas)
+{
+    const char pipeline[]{ "appsrc name=in ! queue ! identity ! appsink name=out" };
+
+    auto feederSource = Pothos::BlockRegistry::make( "/blocks/feeder_source", "int8" );
+
+    auto gstreamer = Pothos::BlockRegistry::make( "/media/gstreamer", pipeline );
+
+    auto reinterpret = Pothos::BlockRegistry::make( "/blocks/reinterpret", "int8" );
+
+    auto collectorSink = Pothos::BlockRegistry::make( "/blocks/collector_sink", "int8" );
+
+    POTHOS_TEST_THROWS( gstreamer.call( "setReplicas", 0 ), Pothos::InvalidArgumentException );
+    gstreamer.call( "setReplicas", 4 );
+
+    json testPlan;
+    testPlan[ "enablePackets" ] = true;
+
+    auto expected = feederSource.call("feedTestPlan", testPlan.dump());
+
+    {
+        Pothos::Topology topology;
+
+        topology.connect( feederSource, 0 , gstreamer, "in" );
+        topology.connect( gstreamer, "out" , reinterpret, 0 );
+        topology.connect( reinterpret, 0 , collectorSink, 0 );
+
+        topology.commit();
+        topology.waitInactive( 1 );
+    }
+
+    // Back in input order, whichever replica each packet went through
+    collectorSink.call("verifyTestPlan", expected);
+}
+
+POTHOS_TEST_BLOCK(testPath, test_gstreamer_replicas_reorder)
+{
+    const char pipeline[]{ "appsrc name=in ! identity name=delay ! appsink name=out" };
+
+    auto feederSource = Pothos::BlockRegistry::make( "/blocks/feeder_source", "int8" );
+
+    auto gstreamer = Pothos::BlockRegistry::make( "/media/gstreamer", pipeline );
+    gstreamer.call( "setReplicas", 2 );
+    // Only a stream can be fed to every replica
+    POTHOS_TEST_THROWS( gstreamer.call( "setStreamType_in", std::string( "RANDOM_ACCESS" ) ), Pothos::Exception );
+    gstreamer.call( "enableElementTiming", std::vector< std::string >{ } );
+
+    auto reinterpret = Pothos::BlockRegistry::make( "/blocks/reinterpret", "int8" );
+
+    auto collectorSink = Pothos::BlockRegistry::make( "/blocks/collector_sink", "int8" );
+
+    json testPlan;
+    testPlan[ "enablePackets" ] = true;
+    testPlan[ "minTrials" ] = 20;
+    testPlan[ "maxTrials" ] = 40;
+
+    auto expected = feederSource.call("feedTestPlan", testPlan.dump());
+
+    {
+        Pothos::Topology topology;
+
+        topology.connect( gstreamer, "out" , reinterpret, 0 );
+        topology.connect( reinterpret, 0 , collectorSink, 0 );
+        topology.commit();
+
+        // The first replica is slower, so the packets of the second come out ahead of it
+        gstreamer.call( "setElementProperty", std::string( "replica0/delay" ), std::string( "sleep-time" ), 20000 );
+        POTHOS_TEST_EQUAL( gstreamer.call< guint64 >( "getCurrentLevelBytes_in" ), 0 );
+
+        topology.connect( feederSource, 0 , gstreamer, "in" );
+        topology.commit();
+        topology.waitInactive( 1 );
+    }
+
+    collectorSink.call("verifyTestPlan", expected);
+
+    // Packets did wait to be put back in order
+    const auto portStats = gstreamer.call< Pothos::ObjectKwargs >( "getPortStats" );
+    const auto &out = portStats.at( "out" ).extract< Pothos::ObjectKwargs >();
+    const auto &histogram = out.at( "occupancyHistogram" ).extract< Pothos::ObjectVector >();
+    uint64_t waited = 0;
+    for (size_t bin = 1; bin < histogram.size(); ++bin)
+    {
+        waited += histogram[ bin ].convert< uint64_t >();
+    }
+    POTHOS_TEST_TRUE( waited != 0 );
+
+    // The elements of the same name in each replica are timed apart
+    const auto timing = gstreamer.call< Pothos::ObjectKwargs >( "getElementTiming" );
+    POTHOS_TEST_EQUAL( timing.count( "replica0/delay" ), 1 );
+    POTHOS_TEST_EQUAL( timing.count( "replica1/delay" ), 1 );
+    uint64_t timed = 0;
+    for (const auto *delay : { "replica0/delay", "replica1/delay" })
+    {
+        timed += timing.at( delay ).extract< Pothos::ObjectKwargs >().at( "count" ).convert< uint64_t >();
+    }
+    POTHOS_TEST_TRUE( timed != 0 );
+}
+
+POTHOS_TEST_BLOCK(testPath, test_gstreamer_clock_domain)
+{
+    // Not syncing, the base time of the domain is from before these pipelines start
+    const char pipeline[]{ "appsrc name=in ! fakesink sync=false" };
+
+    auto feederSource1 = Pothos::BlockRegistry::make( "/blocks/feeder_source", "int8" );
+    auto feederSource2 = Pothos::BlockRegistry::make( "/blocks/feeder_source", "int8" );
+
+    auto gstreamer1 = Pothos::BlockRegistry::make( "/media/gstreamer", pipeline );
+    auto gstreamer2 = Pothos::BlockRegistry::make( "/media/gstreamer", pipeline );
+    gstreamer1.call( "setClockDomain", std::string( "test_gstreamer_clock_domain" ) );
+    gstreamer2.call( "setClockDomain", std::string( "test_gstreamer_clock_domain" ) );
+
+    json testPlan;
+    testPlan[ "enablePackets" ] = true;
+
+    feederSource1.call("feedTestPlan", testPlan.dump());
+    feederSource2.call("feedTestPlan", testPlan.dump());
+
+    {
+        Pothos::Topology topology;
+
+        topology.connect( feederSource1, 0 , gstreamer1, "in" );
+        topology.connect( feederSource2, 0 , gstreamer2, "in" );
+
+        topology.commit();
+        topology.waitInactive( 1 );
+
+        // Both playing on the clock and base time of the domain
+        auto domain = GstStatic::ClockDomain::acquire( "test_gstreamer_clock_domain" );
+        for (auto *gstreamer : { &gstreamer1, &gstreamer2 })
+        {
+            auto element = GST_ELEMENT( gstreamer->call< GstPipeline* >( "getPipeline" ) );
+            POTHOS_TEST_TRUE( element != nullptr );
+            POTHOS_TEST_EQUAL( gst_element_get_base_time( element ), domain->baseTime() );
+            std::unique_ptr< GstClock, GstTypes::GstObjectUnrefFunc > clock( gst_element_get_clock( element ) );
+            POTHOS_TEST_TRUE( clock.get() == domain->clock() );
+        }
+    }
+}
+
+POTHOS_TEST_BLOCK(testPath, test_gstreamer_loop)
+{
+    // A short stream, run offline so it loops as fast as it can
+    const char pipeline[]{ "audiotestsrc num-buffers=10 samplesperbuffer=441 ! audio/x-raw,rate=44100 ! appsink name=out" };
+
+    auto gstreamer = Pothos::BlockRegistry::make( "/media/gstreamer", pipeline );
+    gstreamer.call( "setLoop", true );
+    gstreamer.call( "setOfflineMode", true );
+
+    auto reinterpret = Pothos::BlockRegistry::make( "/blocks/reinterpret", "int8" );
+
+    auto collectorSink = Pothos::BlockRegistry::make( "/blocks/collector_sink", "int8" );
+
+    {
+        Pothos::Topology topology;
+
+        topology.connect( gstreamer, "out" , reinterpret, 0 );
+        topology.connect( reinterpret, 0 , collectorSink, 0 );
+
+        topology.commit();
+
+        // Never ends, so wait for it to have started over a few times
+        const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds( 10 );
+        while ( gstreamer.call< uint64_t >( "getLoopCount" ) < 2 && std::chrono::steady_clock::now() < deadline )
+        {
+            std::this_thread::sleep_for( std::chrono::milliseconds( 10 ) );
+        }
+        POTHOS_TEST_TRUE( gstreamer.call< uint64_t >( "getLoopCount" ) >= 2 );
+    }
+}
+
+POTHOS_TEST_BLOCK(testPath, test_gstreamer_seek)
+{
+    const char pipeline[]{ "audiotestsrc ! audio/x-raw,rate=44100 ! appsink name=out" };
+    const int64_t seekPosition = 60 * GST_SECOND;
+
+    auto gstreamer = Pothos::BlockRegistry::make( "/media/gstreamer", pipeline );
+
+    POTHOS_TEST_THROWS( gstreamer.call( "seek", std::string( "TIME" ), seekPosition, 1.0, std::vector< std::string >{ } ), Pothos::Exception );
+
+    auto reinterpret = Pothos::BlockRegistry::make( "/blocks/reinterpret", "int8" );
+
+    auto collectorSink = Pothos::BlockRegistry::make( "/blocks/collector_sink", "int8" );
+
+    const auto position = [ &gstreamer ]() -> int64_t
+    {
+        try
+        {
+            return gstreamer.call< int64_t >( "getPipelinePosition", std::string( "TIME" ) );
+        }
+        catch (const Pothos::Exception &)
+        {
+            return -1;
+        }
+    };
+
+    {
+        Pothos::Topology topology;
+
+        topology.connect( gstreamer, "out" , reinterpret, 0 );
+        topology.connect( reinterpret, 0 , collectorSink, 0 );
+
+        topology.commit();
+
+        // Plays in real time, so skip ahead of where it could have got to by itself
+        auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds( 10 );
+        while ( position() < 0 && std::chrono::steady_clock::now() < deadline )
+        {
+            std::this_thread::sleep_for( std::chrono::milliseconds( 10 ) );
+        }
+        POTHOS_TEST_THROWS( gstreamer.call( "seek", std::string( "TIME" ), seekPosition, 0.0, std::vector< std::string >{ } ), Pothos::InvalidArgumentException );
+        POTHOS_TEST_THROWS( gstreamer.call( "seek", std::string( "TIME" ), seekPosition, 1.0, std::vector< std::string >{ "NOT_A_FLAG" } ), Pothos::InvalidArgumentException );
+        gstreamer.call( "seek", std::string( "TIME" ), seekPosition, 1.0, std::vector< std::string >{ "FLUSH", "ACCURATE" } );
+
+        deadline = std::chrono::steady_clock::now() + std::chrono::seconds( 10 );
+        while ( position() < seekPosition && std::chrono::steady_clock::now() < deadline )
+        {
+            std::this_thread::sleep_for( std::chrono::milliseconds( 10 ) );
+        }
+        POTHOS_TEST_TRUE( position() >= seekPosition );
+    }
+}
+
+POTHOS_TEST_BLOCK(testPath, test_gstreamer_offline_mode)
+{
+    // 10 seconds of audio, which a sink syncing to the clock would take 10 seconds to play
+    const char pipeline[]{ "audiotestsrc num-buffers=100 samplesperbuffer=4410 ! audio/x-raw,rate=44100 ! appsink name=out" };
+
+    auto gstreamer = Pothos::BlockRegistry::make( "/media/gstreamer", pipeline );
+    gstreamer.call( "setOfflineMode", true );
+
+    // Not playing yet
+    POTHOS_TEST_THROWS( gstreamer.call( "getProcessingSpeed" ), Pothos::Exception );
+
+    auto reinterpret = Pothos::BlockRegistry::make( "/blocks/reinterpret", "int8" );
+
+    auto collectorSink = Pothos::BlockRegistry::make( "/blocks/collector_sink", "int8" );
+
+    {
+        Pothos::Topology topology;
+
+        topology.connect( gstreamer, "out" , reinterpret, 0 );
+        topology.connect( reinterpret, 0 , collectorSink, 0 );
+
+        topology.commit();
+        topology.waitInactive( 1 );
+
+        // Done well within the 10 seconds, even with the second waiting for the topology to go inactive
+        POTHOS_TEST_TRUE( gstreamer.call< double >( "getProcessingSpeed" ) > 1.0 );
+    }
+}
+
+POTHOS_TEST_BLOCK(testPath, test_gstreamer_streaming_cpus)
+{
+#ifdef __linux__
+    // The first CPU this process may run on, CPU 0 can be left out of a container
+    cpu_set_t cpuSet;
+    CPU_ZERO( &cpuSet );
+    POTHOS_TEST_EQUAL( sched_getaffinity( 0, sizeof( cpuSet ), &cpuSet ), 0 );
+    int cpu = 0;
+    while ( cpu < CPU_SETSIZE && !CPU_ISSET( cpu, &cpuSet ) )
+    {
+        ++cpu;
+    }
+    POTHOS_TEST_TRUE( cpu < CPU_SETSIZE );
+
+    // The fakesrc and the queue each have a streaming thread
+    auto gstreamer = Pothos::BlockRegistry::make( "/media/gstreamer", "fakesrc num-buffers=10 ! queue ! appsink name=out" );
+    gstreamer.call( "setStreamingCpus", std::vector< int >{ cpu } );
+
+    auto collectorSink = Pothos::BlockRegistry::make( "/blocks/collector_sink", "int8" );
+
+    {
+        Pothos::Topology topology;
+
+        topology.connect( gstreamer, "out" , collectorSink, 0 );
+
+        topology.commit();
+        topology.waitInactive( 1 );
+
+        POTHOS_TEST_TRUE( gstreamer.call< uint64_t >( "getStreamingThreadCount" ) != 0 );
+    }
+#else
+    POTHOS_TEST_CHECKPOINT();
+#endif
+}
+
 POTHOS_TEST_BLOCK(testPath, test_gstreamer_create_destroy)
 {
     POTHOS_TEST_CHECKPOINT();